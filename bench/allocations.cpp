@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include "allocations.hpp"
+
+using namespace std;
+
+/**
+ * number of heap allocations of the process
+ */
+static atomic<long long> allocations(0);
+
+/**
+ * Allocate and count a block
+ * @param size - size of block
+ * @return - block, nullptr if out of memory
+ */
+static void *allocate(size_t size) noexcept {
+    allocations++;
+    return malloc(size ? size : 1);
+}
+
+/**
+ * Allocate and count a block with an alignment beyond that of malloc
+ * @param size - size of block
+ * @param alignment - alignment, a power of 2
+ * @return - block, nullptr if out of memory
+ */
+static void *allocateAligned(size_t size, align_val_t alignment) noexcept {
+    allocations++;
+    auto bytes = static_cast<size_t>(alignment);
+    // the block returned by malloc is stored right before the aligned one
+    void *block = malloc(size + bytes + sizeof(void *));
+    if (!block) {
+        return nullptr;
+    }
+    uintptr_t address = (reinterpret_cast<uintptr_t>(block) + sizeof(void *) + bytes - 1) & ~(bytes - 1);
+    reinterpret_cast<void **>(address)[-1] = block;
+    return reinterpret_cast<void *>(address);
+}
+
+/**
+ * Free a block of allocateAligned
+ * @param pointer - block
+ */
+static void releaseAligned(void *pointer) noexcept {
+    if (pointer) {
+        free(static_cast<void **>(pointer)[-1]);
+    }
+}
+
+// every replaceable form is replaced, so that no block is freed by a function not matching its allocation.
+// They are kept out of the benchmark's translation unit so that free is not inlined next to a new expression
+
+void *operator new(size_t size) {
+    if (void *pointer = allocate(size)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    if (void *pointer = allocate(size)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new(size_t size, align_val_t alignment) {
+    if (void *pointer = allocateAligned(size, alignment)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size, align_val_t alignment) {
+    if (void *pointer = allocateAligned(size, alignment)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void *operator new(size_t size, align_val_t alignment, const nothrow_t &) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void *operator new[](size_t size, align_val_t alignment, const nothrow_t &) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete(void *pointer, const nothrow_t &) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer, const nothrow_t &) noexcept {
+    free(pointer);
+}
+
+void operator delete(void *pointer, align_val_t) noexcept {
+    releaseAligned(pointer);
+}
+
+void operator delete[](void *pointer, align_val_t) noexcept {
+    releaseAligned(pointer);
+}
+
+void operator delete(void *pointer, size_t, align_val_t) noexcept {
+    releaseAligned(pointer);
+}
+
+void operator delete[](void *pointer, size_t, align_val_t) noexcept {
+    releaseAligned(pointer);
+}
+
+void operator delete(void *pointer, align_val_t, const nothrow_t &) noexcept {
+    releaseAligned(pointer);
+}
+
+void operator delete[](void *pointer, align_val_t, const nothrow_t &) noexcept {
+    releaseAligned(pointer);
+}
+
+/**
+ * Number of heap allocations of the process so far
+ * @return - number of allocations
+ */
+long long allocationCount() {
+    return allocations;
+}
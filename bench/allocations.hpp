@@ -0,0 +1,10 @@
+#ifndef PARSER_ALLOCATIONS_HPP
+#define PARSER_ALLOCATIONS_HPP
+
+/**
+ * Number of heap allocations of the process so far
+ * @return - number of allocations
+ */
+long long allocationCount();
+
+#endif //PARSER_ALLOCATIONS_HPP
@@ -0,0 +1,583 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include "../src/cparser.hpp"
+#include "../src/metrics.hpp"
+#include "allocations.hpp"
+
+/**
+ * Options of a benchmark run
+ */
+struct Options {
+    string filter;
+    vector<string> inputs;
+    int repetitions = 15;
+    double minTime = 20;
+    bool json = false;
+};
+
+/**
+ * Benchmark case measuring one operation
+ */
+struct Case {
+    string name;
+    size_t bytes;
+    function<void()> body;
+    /**
+     * number of AST nodes handled by one operation, 0 if not counted
+     */
+    long long nodes = 0;
+};
+
+/**
+ * Statistics of a benchmark case in nanoseconds per operation
+ */
+struct Summary {
+    string name;
+    long long iterations;
+    double min;
+    double median;
+    double mean;
+    double stddev;
+    double max;
+    double throughput;
+    double allocations;
+};
+
+/**
+ * Pass counting nodes of one kind
+ */
+struct CountingPass : Pass {
+    long long count = 0;
+
+    explicit CountingPass(const string &kind) {
+        onEnter(kind, [this](const AstIndex &, uint32_t) { count++; });
+    }
+};
+
+/**
+ * Access to internals of parser and formatter
+ */
+struct Benchmark {
+    /**
+     * results of measured operations, stored through volatile so that the operations are not optimized away
+     */
+    static volatile long long sink;
+
+    /**
+     * Create a parser standing at the first character of source
+     * @param source - source code
+     * @return - parser
+     */
+    static Parser prepare(const string &source) {
+        Parser parser(source);
+        parser.next();
+        return parser;
+    }
+
+    /**
+     * Move parser to a position
+     * @param parser - parser
+     * @param index - position
+     */
+    static void seek(Parser &parser, int index) {
+        parser.index = index;
+        parser.curr = parser.source[index];
+    }
+
+    /**
+     * Case of lookahead matching a keyword and rewinding
+     * @param name - name of case
+     * @param keyword - keyword at the start of source
+     * @param pattern - string to look ahead for
+     * @return - case
+     */
+    static Case lookahead(const string &name, const string &keyword, const string &pattern) {
+        auto parser = make_shared<Parser>(prepare(keyword + " (x);\n"));
+        int start = parser->index;
+        return {name, pattern.size(), [=] {
+            sink += parser->lookahead(pattern);
+            seek(*parser, start);
+        }};
+    }
+
+    /**
+     * Case of scanning binary operator
+     * @param op - operator in source
+     * @return - case
+     */
+    static Case scanBinaryOperator(const string &op) {
+        auto parser = make_shared<Parser>(prepare(op + " b;\n"));
+        return {"scanBinaryOperator/" + op, op.size(), [=] {
+            sink += parser->scanBinaryOperator().size();
+        }};
+    }
+
+    /**
+     * Case of determining incoming declaration
+     * @param name - name of case
+     * @param source - source code at the position of statement
+     * @param typedefs - number of type definitions before statement
+     * @return - case
+     */
+    static Case declarationIncoming(const string &name, const string &source, int typedefs) {
+        string code;
+        for (int i = 0; i < typedefs; i++) {
+            code += "typedef int type" + to_string(i) + ";\n";
+        }
+        auto parser = make_shared<Parser>(prepare(code + source));
+        for (int i = 0; i < typedefs; i++) {
+            parser->symbols.declare("type" + to_string(i), SymbolKind::Type, 0);
+        }
+        seek(*parser, static_cast<int>(code.size()));
+        return {name, source.size(), [=] {
+            sink += parser->declarationIncoming();
+        }};
+    }
+
+    /**
+     * Case of parsing expression
+     * @param name - name of case
+     * @param source - expression terminated by semicolon
+     * @return - case
+     */
+    static Case parseExpression(const string &name, const string &source) {
+        return {name, source.size(), [=] {
+            Parser parser = prepare(source);
+            sink += parser.parseExpression(";").size();
+        }};
+    }
+
+    /**
+     * Case of formatting parsed program
+     * @param name - name of case
+     * @param source - source code
+     * @return - case
+     */
+    static Case format(const string &name, const string &source) {
+        auto formatter = make_shared<Formatter>(Parser(source).parse().dump());
+        return {name, source.size(), [=] {
+            formatter->stream.str("");
+            formatter->format(formatter->src);
+            sink += formatter->stream.tellp();
+        }, Metrics::countNodes(formatter->src)};
+    }
+
+    /**
+     * Case of parsing program with a fresh or a reused parser
+     * @param name - name of case
+     * @param source - source code
+     * @param reuse - whether parser is reset instead of constructed
+     * @return - case
+     */
+    static Case parse(const string &name, const string &source, bool reuse) {
+        auto parser = make_shared<Parser>();
+        return {name, source.size(), [=] {
+            if (reuse) {
+                parser->reset(source);
+                sink += parser->parse().size();
+            } else {
+                sink += Parser(source).parse().size();
+            }
+        }};
+    }
+
+    /**
+     * Case of running counting passes over an indexed program, in one traversal or one traversal per pass
+     * @param name - name of case
+     * @param source - source code
+     * @param fused - whether passes share a traversal
+     * @return - case
+     */
+    static Case visit(const string &name, const string &source, bool fused) {
+        static const char *kinds[] = {"CallExpression", "Identifier", "NumberLiteral", "BinaryExpression",
+                                      "IfStatement", "DoWhileStatement", "ForStatement", "ReturnStatement",
+                                      "VariableDefinition", "FunctionDefinition"};
+        auto tree = make_shared<json>(Parser(source).parse());
+        auto index = make_shared<AstIndex>(*tree);
+        auto passes = make_shared<vector<unique_ptr<CountingPass>>>();
+        Traversal check;
+        for (const char *kind: kinds) {
+            passes->push_back(make_unique<CountingPass>(kind));
+            check.add(*passes->back());
+        }
+        // a pass whose kind never occurs would only measure dispatch
+        check.run(*index);
+        for (size_t i = 0; i < passes->size(); i++) {
+            if ((*passes)[i]->count == 0) {
+                throw runtime_error(name + ": no " + kinds[i] + " in program");
+            }
+        }
+        return {name, source.size(), [=] {
+            if (fused) {
+                Traversal traversal;
+                for (auto &pass: *passes) {
+                    traversal.add(*pass);
+                }
+                traversal.run(*index);
+            } else {
+                for (auto &pass: *passes) {
+                    Traversal().add(*pass).run(*index);
+                }
+            }
+            sink += passes->front()->count;
+        }};
+    }
+
+    /**
+     * Count identifier nodes in a JSON tree
+     * @param value - JSON tree
+     * @return - number of nodes of kind Identifier
+     */
+    static long long countIdentifiers(const json &value) {
+        long long identifiers = 0;
+        if (value.is_object()) {
+            auto kind = value.find("kind");
+            identifiers += kind != value.end() && kind->get_ref<const string &>() == "Identifier";
+        }
+        if (value.is_structured()) {
+            for (const json &child: value) {
+                identifiers += countIdentifiers(child);
+            }
+        }
+        return identifiers;
+    }
+
+    /**
+     * Case of walking all nodes of a parsed program to count identifiers, in JSON or in a flat tree
+     * @param name - name of case
+     * @param source - source code
+     * @param flat - whether the flat tree is walked
+     * @return - case
+     */
+    static Case walk(const string &name, const string &source, bool flat) {
+        auto tree = make_shared<json>(Parser(source).parse());
+        auto flatTree = make_shared<FlatTree>(*tree);
+        return {name, source.size(), [=] {
+            long long identifiers = 0;
+            if (flat) {
+                uint32_t identifier = flatTree->id("Identifier");
+                for (uint32_t node = 0; node < flatTree->size(); node++) {
+                    identifiers += flatTree->kind(node) == identifier;
+                }
+            } else {
+                identifiers = countIdentifiers(*tree);
+            }
+            sink += identifiers;
+        }};
+    }
+
+    /**
+     * Case of serializing a parsed program as indented JSON to a stream, through its whole text or
+     * through the streaming writer
+     * @param name - name of case
+     * @param source - source code
+     * @param streaming - whether the streaming writer is used
+     * @return - case
+     */
+    static Case serialize(const string &name, const string &source, bool streaming) {
+        auto tree = make_shared<json>(Parser(source).parse());
+        return {name, source.size(), [=] {
+            // a stream without buffer discards output, so only serialization is measured
+            ostream out(nullptr);
+            if (streaming) {
+                JsonWriter writer(out, 2);
+                writer.write(*tree);
+            } else {
+                string text = tree->dump(2);
+                out << text;
+                sink += text.size();
+            }
+        }};
+    }
+
+    /**
+     * Case of loading an AST from its indented JSON text, as a DOM or with the formatter's loader
+     * @param name - name of case
+     * @param source - source code
+     * @param loader - whether the formatter's loader is used
+     * @return - case
+     */
+    static Case load(const string &name, const string &source, bool loader) {
+        string text = Parser(source).parse().dump(2);
+        return {name, text.size(), [=] {
+            sink += (loader ? AstLoader::load(text) : json::parse(text))["body"].size();
+        }};
+    }
+
+    /**
+     * Case of parsing and formatting program
+     * @param name - name of case
+     * @param source - source code
+     * @return - case
+     */
+    static Case endToEnd(const string &name, const string &source) {
+        return {name, source.size(), [=] {
+            Formatter formatter(Parser(source).parse().dump(2));
+            formatter.render();
+            sink += formatter.stream.tellp();
+        }};
+    }
+};
+
+volatile long long Benchmark::sink = 0;
+
+/**
+ * Expression chaining operators of all precedences
+ * @param operands - number of operands
+ * @return - expression terminated by semicolon
+ */
+string chain(int operands) {
+    static const char *ops[] = {"+", "*", "-", "/", "<<", "&", "|", "==", "&&", "||"};
+    string expression = "a0";
+    for (int i = 1; i < operands; i++) {
+        expression += string(" ") + ops[i % 10] + " a" + to_string(i);
+    }
+    return expression + ";\n";
+}
+
+/**
+ * Program with many top-level items
+ * @param items - number of global definitions and functions
+ * @return - source code
+ */
+string wideProgram(int items) {
+    string code;
+    for (int i = 0; i < items; i++) {
+        code += "int g" + to_string(i) + " = " + to_string(i) + " * 2 + 1;\n";
+        code += "int f" + to_string(i) + "(int a) {\n    return a + g" + to_string(i) + ";\n}\n";
+    }
+    return code;
+}
+
+/**
+ * Program with deeply nested statements
+ * @param depth - nesting depth
+ * @return - source code
+ */
+string deepProgram(int depth) {
+    string code = "int main() {\n";
+    for (int i = 0; i < depth; i++) {
+        code += i % 2 ? "while (x > " + to_string(i) + ") {\n" : "if (x < " + to_string(i) + ") {\n";
+    }
+    code += "x = x - 1;\n";
+    for (int i = 0; i < depth; i++) {
+        code += "}\n";
+    }
+    return code + "}\n";
+}
+
+/**
+ * Program made of string tables
+ * @param entries - number of string definitions
+ * @return - source code
+ */
+string stringTable(int entries) {
+    string code;
+    for (int i = 0; i < entries; i++) {
+        code += "char s" + to_string(i) + "[96] = \"resource entry " + to_string(i) +
+                " with a fairly long payload of text\\n and \\x41 escapes\";\n";
+    }
+    return code;
+}
+
+/**
+ * Program using every supported construct
+ * @param functions - number of functions
+ * @return - source code
+ */
+string mixedProgram(int functions) {
+    string code = "#include <stdio.h>\n#define MAX 100\ntypedef int myint;\n";
+    for (int i = 0; i < functions; i++) {
+        string n = to_string(i);
+        code += "// function " + n + "\n"
+                "myint table" + n + "[4] = {1, 0x2F, 077, 'a'};\n"
+                "int work" + n + "(int a, char b) {\n"
+                "    /* body of work */\n"
+                "    int i = 0, j = 1;\n"
+                "    for (int k = 0; k < MAX; k += 1) {\n"
+                "        if (k % 3 == 0 && a != k) {\n"
+                "            j = j * (a + k) - table" + n + "[k % 4];\n"
+                "        } else {\n"
+                "            j = printf(\"%d\\n\", j);\n"
+                "        }\n"
+                "    }\n"
+                "    do {\n"
+                "        i = i + 1;\n"
+                "    } while (i < 10);\n"
+                "    return i + j;\n"
+                "}\n";
+    }
+    return code;
+}
+
+/**
+ * Measure a case
+ * @param benchmark - case
+ * @param options - options of run
+ * @return - statistics
+ */
+Summary measure(const Case &benchmark, const Options &options) {
+    using clock = chrono::steady_clock;
+    auto run = [&](long long iterations) {
+        auto start = clock::now();
+        for (long long i = 0; i < iterations; i++) {
+            benchmark.body();
+        }
+        return static_cast<double>(chrono::duration_cast<chrono::nanoseconds>(clock::now() - start).count());
+    };
+    // calibrate iterations so that each sample takes at least minTime milliseconds
+    long long iterations = 1;
+    double elapsed = run(iterations);
+    while (elapsed < options.minTime * 1e6 && iterations < (1LL << 40)) {
+        double scale = elapsed > 0 ? options.minTime * 1e6 / elapsed : 10;
+        iterations = max(iterations + 1, static_cast<long long>(iterations * min(10.0, scale * 1.2)));
+        elapsed = run(iterations);
+    }
+    vector<double> samples;
+    for (int i = 0; i < options.repetitions; i++) {
+        samples.push_back(run(iterations) / iterations);
+    }
+    sort(samples.begin(), samples.end());
+    Summary summary{};
+    summary.name = benchmark.name;
+    summary.iterations = iterations;
+    summary.min = samples.front();
+    summary.max = samples.back();
+    size_t middle = samples.size() / 2;
+    summary.median = samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+    double sum = 0;
+    for (double sample: samples) {
+        sum += sample;
+    }
+    summary.mean = sum / samples.size();
+    double variance = 0;
+    for (double sample: samples) {
+        variance += (sample - summary.mean) * (sample - summary.mean);
+    }
+    summary.stddev = samples.size() > 1 ? sqrt(variance / (samples.size() - 1)) : 0;
+    summary.throughput = benchmark.bytes * 1e3 / summary.median;
+    long long allocationsBefore = allocationCount();
+    run(iterations);
+    summary.allocations = static_cast<double>(allocationCount() - allocationsBefore) / iterations;
+    return summary;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            options.repetitions = max(1, stoi(argv[++i]));
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.minTime = stod(argv[++i]);
+        } else if (arg == "--input" && i + 1 < argc) {
+            options.inputs.emplace_back(argv[++i]);
+        } else {
+            cerr << "usage: benchmark [--json] [--filter substring] [--repetitions n] [--min-time ms]"
+                    " [--input file]...\n";
+            return 1;
+        }
+    }
+
+    vector<Case> cases = {
+            Benchmark::lookahead("lookahead/hit", "while", "while"),
+            Benchmark::lookahead("lookahead/miss", "while", "whale"),
+            Benchmark::lookahead("lookahead/prefix", "whiles", "while"),
+            Benchmark::scanBinaryOperator("<<="),
+            Benchmark::scanBinaryOperator("&&"),
+            Benchmark::scanBinaryOperator("%"),
+            Benchmark::scanBinaryOperator("->"),
+            Benchmark::declarationIncoming("declarationIncoming/int", "int x;\n", 0),
+            Benchmark::declarationIncoming("declarationIncoming/miss", "x = 1;\n", 0),
+            Benchmark::declarationIncoming("declarationIncoming/miss-100-typedefs", "x = 1;\n", 100),
+            Benchmark::declarationIncoming("declarationIncoming/miss-1000-typedefs", "x = 1;\n", 1000),
+            Benchmark::parseExpression("parseExpression/chain-10", chain(10)),
+            Benchmark::parseExpression("parseExpression/chain-100", chain(100)),
+            Benchmark::parseExpression("parseExpression/chain-1000", chain(1000)),
+            Benchmark::format("format/wide-500", wideProgram(500)),
+            Benchmark::format("format/deep-100", deepProgram(100)),
+            Benchmark::format("format/deep-1000", deepProgram(1000)),
+            Benchmark::format("format/mixed-200", mixedProgram(200)),
+            Benchmark::parse("parse/strings-200", stringTable(200), false),
+            Benchmark::parse("parse/mixed-20", mixedProgram(20), false),
+            Benchmark::parse("parse/mixed-20-reused", mixedProgram(20), true),
+            Benchmark::visit("visit/10-passes-fused", mixedProgram(20), true),
+            Benchmark::visit("visit/10-passes-separate", mixedProgram(20), false),
+            Benchmark::walk("walk/json-200", mixedProgram(200), false),
+            Benchmark::walk("walk/flat-200", mixedProgram(200), true),
+            Benchmark::serialize("serialize/dump-200", mixedProgram(200), false),
+            Benchmark::serialize("serialize/writer-200", mixedProgram(200), true),
+            Benchmark::load("load/dom-200", mixedProgram(200), false),
+            Benchmark::load("load/loader-200", mixedProgram(200), true),
+            Benchmark::endToEnd("endToEnd/mixed-20", mixedProgram(20)),
+            Benchmark::endToEnd("endToEnd/mixed-200", mixedProgram(200)),
+    };
+    for (const string &input: options.inputs) {
+        ifstream file(input, ios::binary);
+        if (!file.good()) {
+            cerr << "Cannot read " << input << "\n";
+            return 1;
+        }
+        stringstream content;
+        content << file.rdbuf();
+        cases.push_back(Benchmark::format("format/" + input, content.str()));
+        cases.push_back(Benchmark::endToEnd("endToEnd/" + input, content.str()));
+    }
+
+    json results = json::array();
+    if (!options.json) {
+        cout << left << setw(42) << "Benchmark" << right << setw(16) << "Median ns" << setw(16) << "Mean ns"
+             << setw(10) << "Stddev%" << setw(16) << "Min ns" << setw(16) << "Max ns" << setw(12) << "MB/s"
+             << setw(12) << "Iterations" << setw(12) << "Allocs/op" << setw(12) << "Allocs/node" << "\n";
+    }
+    for (const Case &benchmark: cases) {
+        if (benchmark.name.find(options.filter) == string::npos) {
+            continue;
+        }
+        Summary summary = measure(benchmark, options);
+        if (options.json) {
+            results.push_back({
+                                      {"name",       summary.name},
+                                      {"iterations", summary.iterations},
+                                      {"repetitions", options.repetitions},
+                                      {"bytes",      benchmark.bytes},
+                                      {"min",        summary.min},
+                                      {"median",     summary.median},
+                                      {"mean",       summary.mean},
+                                      {"stddev",     summary.stddev},
+                                      {"max",        summary.max},
+                                      {"throughput", summary.throughput},
+                                      {"allocations", summary.allocations},
+                              });
+            if (benchmark.nodes > 0) {
+                results.back()["nodes"] = benchmark.nodes;
+                results.back()["allocationsPerNode"] = summary.allocations / benchmark.nodes;
+            }
+        } else {
+            cout << left << setw(42) << summary.name << right << fixed << setprecision(1)
+                 << setw(16) << summary.median << setw(16) << summary.mean
+                 << setw(10) << 100 * summary.stddev / summary.mean
+                 << setw(16) << summary.min << setw(16) << summary.max
+                 << setw(12) << setprecision(2) << summary.throughput
+                 << setw(12) << summary.iterations << setw(12) << setprecision(1) << summary.allocations;
+            if (benchmark.nodes > 0) {
+                cout << setw(12) << setprecision(2) << summary.allocations / benchmark.nodes << "\n";
+            } else {
+                cout << setw(12) << "-" << "\n";
+            }
+        }
+    }
+    if (options.json) {
+        cout << results.dump(2) << "\n";
+    }
+    return 0;
+}
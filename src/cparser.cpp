@@ -0,0 +1,36 @@
+#include "cparser.hpp"
+
+/**
+ * Parse C source code
+ * @param source - source code
+ * @param options - options of parsing
+ * @return - JSON tree of program
+ */
+json parseSource(string_view source, const ParseOptions &options) {
+    return Parser(string(source), options).parse();
+}
+
+/**
+ * Format AST of program
+ * @param tree - JSON tree of program
+ * @param options - options of formatting
+ * @return - formatted code
+ */
+string formatTree(const json &tree, const FormatOptions &options) {
+    Formatter formatter(tree, options);
+    formatter.render();
+    return formatter.result();
+}
+
+/**
+ * Parse and format C source code
+ * @param source - source code
+ * @param parseOptions - options of parsing
+ * @param formatOptions - options of formatting
+ * @return - formatted code
+ */
+string formatSource(string_view source, const ParseOptions &parseOptions, const FormatOptions &formatOptions) {
+    Formatter formatter(parseSource(source, parseOptions), formatOptions);
+    formatter.render();
+    return formatter.result();
+}
@@ -0,0 +1,42 @@
+#ifndef PARSER_CPARSER_HPP
+#define PARSER_CPARSER_HPP
+
+#include <string_view>
+#include "flat.hpp"
+#include "headers.hpp"
+#include "lint.hpp"
+#include "loader.hpp"
+#include "parser.hpp"
+#include "query.hpp"
+#include "visitor.hpp"
+#include "formatter.hpp"
+#include "writer.hpp"
+#include "xref.hpp"
+
+/**
+ * Parse C source code
+ * @param source - source code
+ * @param options - options of parsing
+ * @return - JSON tree of program
+ */
+json parseSource(string_view source, const ParseOptions &options = ParseOptions());
+
+/**
+ * Format AST of program
+ * @param tree - JSON tree of program
+ * @param options - options of formatting
+ * @return - formatted code
+ */
+string formatTree(const json &tree, const FormatOptions &options = FormatOptions());
+
+/**
+ * Parse and format C source code
+ * @param source - source code
+ * @param parseOptions - options of parsing
+ * @param formatOptions - options of formatting
+ * @return - formatted code
+ */
+string formatSource(string_view source, const ParseOptions &parseOptions = ParseOptions(),
+                    const FormatOptions &formatOptions = FormatOptions());
+
+#endif //PARSER_CPARSER_HPP
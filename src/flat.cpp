@@ -0,0 +1,251 @@
+#include "flat.hpp"
+
+/**
+ * Constructor of class
+ * @param root - JSON tree of program
+ */
+FlatTree::FlatTree(const json &root) {
+    intern("");
+    nullKind = intern("null");
+    if (root.is_object()) {
+        add(root, 0);
+    }
+    payloads.push_back(static_cast<uint32_t>(attributes.size()));
+}
+
+/**
+ * Id of a kind or field name
+ * @param name - name
+ * @return - id
+ */
+uint32_t FlatTree::intern(const string &name) {
+    auto found = ids.find(name);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    names.push_back(name);
+    ids.emplace(name, static_cast<uint32_t>(names.size() - 1));
+    return static_cast<uint32_t>(names.size() - 1);
+}
+
+/**
+ * Whether a JSON value is stored as children, i.e. is a node or an array of nodes and nulls
+ * @param value - JSON value
+ * @return - result
+ */
+bool FlatTree::isStructural(const json &value) {
+    if (value.is_object()) {
+        return value.find("kind") != value.end();
+    }
+    if (!value.is_array()) {
+        return false;
+    }
+    bool hasNode = false;
+    for (const json &item: value) {
+        if (item.is_object() && item.find("kind") != item.end()) {
+            hasNode = true;
+        } else if (!item.is_null()) {
+            return false;
+        }
+    }
+    return hasNode;
+}
+
+/**
+ * Add a node and its subtree
+ * @param value - JSON tree of node, null for a null item of an array
+ * @param field - field of node in parent
+ * @return - index of node
+ */
+uint32_t FlatTree::add(const json &value, uint32_t field) {
+    auto index = static_cast<uint32_t>(kinds.size());
+    kinds.push_back(value.is_null() ? nullKind : intern(value["kind"].get_ref<const string &>()));
+    positions.push_back(noPosition);
+    spans.push_back(0);
+    firstChildren.push_back(none);
+    nextSiblings.push_back(none);
+    fields.push_back(field);
+    payloads.push_back(static_cast<uint32_t>(attributes.size()));
+    if (value.is_null()) {
+        spans[index] = index + 1;
+        return index;
+    }
+    // scalar fields go to the payload table before any child is added
+    for (auto item = value.begin(); item != value.end(); ++item) {
+        if (item.key() == "kind" || isStructural(item.value())) {
+            continue;
+        }
+        if (item.key() == "position" && item.value().is_number_integer()) {
+            positions[index] = item.value().get<int32_t>();
+        } else {
+            attributes.push_back({intern(item.key()), item.value()});
+        }
+    }
+    uint32_t previous = none;
+    auto link = [&](uint32_t child) {
+        if (previous == none) {
+            firstChildren[index] = child;
+        } else {
+            nextSiblings[previous] = child;
+        }
+        previous = child;
+    };
+    for (auto item = value.begin(); item != value.end(); ++item) {
+        if (item.key() == "kind" || !isStructural(item.value())) {
+            continue;
+        }
+        uint32_t id = intern(item.key());
+        if (item.value().is_array()) {
+            for (const json &element: item.value()) {
+                link(add(element, id | listItem));
+            }
+        } else {
+            link(add(item.value(), id));
+        }
+    }
+    spans[index] = static_cast<uint32_t>(kinds.size());
+    return index;
+}
+
+/**
+ * Number of nodes
+ * @return - number of nodes
+ */
+size_t FlatTree::size() const {
+    return kinds.size();
+}
+
+/**
+ * Kind id of a node
+ * @param node - index of node
+ * @return - id of kind
+ */
+uint32_t FlatTree::kind(uint32_t node) const {
+    return kinds[node];
+}
+
+/**
+ * Kind of a node
+ * @param node - index of node
+ * @return - kind
+ */
+const string &FlatTree::kindName(uint32_t node) const {
+    return names[kinds[node]];
+}
+
+/**
+ * Id of a kind or field name
+ * @param name - name
+ * @return - id, none if no node has it
+ */
+uint32_t FlatTree::id(const string &name) const {
+    auto found = ids.find(name);
+    return found == ids.end() ? none : found->second;
+}
+
+/**
+ * Line of a node
+ * @param node - index of node
+ * @return - line, noPosition if node has none
+ */
+int32_t FlatTree::position(uint32_t node) const {
+    return positions[node];
+}
+
+/**
+ * End of subtree of a node
+ * @param node - index of node
+ * @return - index after last node of subtree
+ */
+uint32_t FlatTree::end(uint32_t node) const {
+    return spans[node];
+}
+
+/**
+ * First child of a node
+ * @param node - index of node
+ * @return - index of child, none if node is a leaf
+ */
+uint32_t FlatTree::firstChild(uint32_t node) const {
+    return firstChildren[node];
+}
+
+/**
+ * Next sibling of a node
+ * @param node - index of node
+ * @return - index of sibling, none if node is the last child
+ */
+uint32_t FlatTree::nextSibling(uint32_t node) const {
+    return nextSiblings[node];
+}
+
+/**
+ * Field storing a node in its parent
+ * @param node - index of node
+ * @return - name of field, empty for root
+ */
+const string &FlatTree::field(uint32_t node) const {
+    return names[fields[node] & ~listItem];
+}
+
+/**
+ * Whether a node is an item of an array field
+ * @param node - index of node
+ * @return - result
+ */
+bool FlatTree::isListItem(uint32_t node) const {
+    return (fields[node] & listItem) != 0;
+}
+
+/**
+ * Whether a node stands for a null item of an array
+ * @param node - index of node
+ * @return - result
+ */
+bool FlatTree::isNull(uint32_t node) const {
+    return kinds[node] == nullKind;
+}
+
+/**
+ * Scalar field of a node
+ * @param node - index of node
+ * @param name - name of field
+ * @return - value, nullptr if node has no such scalar field
+ */
+const json *FlatTree::attribute(uint32_t node, const string &name) const {
+    uint32_t field = id(name);
+    for (uint32_t i = payloads[node]; i < payloads[node + 1]; i++) {
+        if (attributes[i].field == field) {
+            return &attributes[i].value;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Convert a subtree back to JSON
+ * @param node - index of node
+ * @return - JSON tree equal to the one stored
+ */
+json FlatTree::toJson(uint32_t node) const {
+    if (node >= kinds.size() || kinds[node] == nullKind) {
+        return nullptr;
+    }
+    json value = json::object();
+    value["kind"] = names[kinds[node]];
+    if (positions[node] != noPosition) {
+        value["position"] = positions[node];
+    }
+    for (uint32_t i = payloads[node]; i < payloads[node + 1]; i++) {
+        value[names[attributes[i].field]] = attributes[i].value;
+    }
+    for (uint32_t child = firstChildren[node]; child != none; child = nextSiblings[child]) {
+        json &slot = value[field(child)];
+        if (isListItem(child)) {
+            slot.push_back(toJson(child));
+        } else {
+            slot = toJson(child);
+        }
+    }
+    return value;
+}
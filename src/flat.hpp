@@ -0,0 +1,176 @@
+#ifndef PARSER_FLAT_HPP
+#define PARSER_FLAT_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include "../lib/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * AST stored as struct of arrays, nodes being numbered in preorder.
+ * Each node has a kind, a line, the end of its subtree, links to its first child and next sibling, the field
+ * it is stored in by its parent and a range of scalar fields in one payload table, so a walk over all nodes
+ * is a linear scan of a few arrays instead of a chase through JSON objects
+ */
+class FlatTree {
+public:
+    /**
+     * scalar field of a node, or array of scalars
+     */
+    struct Attribute {
+        uint32_t field;
+        json value;
+    };
+
+    /**
+     * index of no node
+     */
+    static constexpr uint32_t none = UINT32_MAX;
+
+    /**
+     * line of a node without position
+     */
+    static constexpr int32_t noPosition = INT32_MIN;
+
+private:
+    /**
+     * flag of field of a node stored as an item of an array
+     */
+    static constexpr uint32_t listItem = uint32_t(1) << 31;
+
+    vector<uint32_t> kinds;
+    vector<int32_t> positions;
+    vector<uint32_t> spans;
+    vector<uint32_t> firstChildren;
+    vector<uint32_t> nextSiblings;
+    vector<uint32_t> fields;
+    vector<uint32_t> payloads;
+    vector<Attribute> attributes;
+    vector<string> names;
+    unordered_map<string, uint32_t> ids;
+    uint32_t nullKind;
+
+    /**
+     * Id of a kind or field name
+     * @param name - name
+     * @return - id
+     */
+    uint32_t intern(const string &name);
+
+    /**
+     * Whether a JSON value is stored as children, i.e. is a node or an array of nodes and nulls
+     * @param value - JSON value
+     * @return - result
+     */
+    static bool isStructural(const json &value);
+
+    /**
+     * Add a node and its subtree
+     * @param value - JSON tree of node, null for a null item of an array
+     * @param field - field of node in parent
+     * @return - index of node
+     */
+    uint32_t add(const json &value, uint32_t field);
+
+public:
+    /**
+     * Constructor of class
+     * @param root - JSON tree of program
+     */
+    explicit FlatTree(const json &root);
+
+    /**
+     * Number of nodes
+     * @return - number of nodes
+     */
+    size_t size() const;
+
+    /**
+     * Kind id of a node
+     * @param node - index of node
+     * @return - id of kind
+     */
+    uint32_t kind(uint32_t node) const;
+
+    /**
+     * Kind of a node
+     * @param node - index of node
+     * @return - kind
+     */
+    const string &kindName(uint32_t node) const;
+
+    /**
+     * Id of a kind or field name
+     * @param name - name
+     * @return - id, none if no node has it
+     */
+    uint32_t id(const string &name) const;
+
+    /**
+     * Line of a node
+     * @param node - index of node
+     * @return - line, noPosition if node has none
+     */
+    int32_t position(uint32_t node) const;
+
+    /**
+     * End of subtree of a node
+     * @param node - index of node
+     * @return - index after last node of subtree
+     */
+    uint32_t end(uint32_t node) const;
+
+    /**
+     * First child of a node
+     * @param node - index of node
+     * @return - index of child, none if node is a leaf
+     */
+    uint32_t firstChild(uint32_t node) const;
+
+    /**
+     * Next sibling of a node
+     * @param node - index of node
+     * @return - index of sibling, none if node is the last child
+     */
+    uint32_t nextSibling(uint32_t node) const;
+
+    /**
+     * Field storing a node in its parent
+     * @param node - index of node
+     * @return - name of field, empty for root
+     */
+    const string &field(uint32_t node) const;
+
+    /**
+     * Whether a node is an item of an array field
+     * @param node - index of node
+     * @return - result
+     */
+    bool isListItem(uint32_t node) const;
+
+    /**
+     * Whether a node stands for a null item of an array
+     * @param node - index of node
+     * @return - result
+     */
+    bool isNull(uint32_t node) const;
+
+    /**
+     * Scalar field of a node
+     * @param node - index of node
+     * @param name - name of field
+     * @return - value, nullptr if node has no such scalar field
+     */
+    const json *attribute(uint32_t node, const string &name) const;
+
+    /**
+     * Convert a subtree back to JSON
+     * @param node - index of node
+     * @return - JSON tree equal to the one stored
+     */
+    json toJson(uint32_t node = 0) const;
+};
+
+#endif //PARSER_FLAT_HPP
@@ -0,0 +1,284 @@
+#include "folding.hpp"
+
+/**
+ * Mask of the bits of a type
+ * @param width - width of type
+ * @return - mask
+ */
+static uint64_t mask(int width) {
+    return width == 64 ? UINT64_MAX : (uint64_t(1) << width) - 1;
+}
+
+/**
+ * Width of a type in bits
+ * @param rank - 0 for int, 1 for long, 2 for long long
+ * @return - width
+ */
+int ConstantFolder::width(int rank) {
+    return rank == 0 ? 32 : 64;
+}
+
+/**
+ * Value of a constant as a signed number
+ * @param constant - constant of a signed type
+ * @return - value
+ */
+int64_t ConstantFolder::toSigned(const IntegerConstant &constant) {
+    if (width(constant.rank) == 64) {
+        return static_cast<int64_t>(constant.bits);
+    }
+    return static_cast<int32_t>(static_cast<uint32_t>(constant.bits));
+}
+
+/**
+ * Value and type of an integer literal
+ * @param literal - JSON tree of literal, possibly in parentheses
+ * @param constant - value and type
+ * @return - false if tree is not an integer literal or its value fits no type
+ */
+bool ConstantFolder::decode(const json &literal, IntegerConstant &constant) {
+    static const string suffix = "NumberLiteral";
+    if (!literal.is_object()) {
+        return false;
+    }
+    auto kindField = literal.find("kind");
+    if (kindField == literal.end() || !kindField->is_string()) {
+        return false;
+    }
+    const string &kind = kindField->get_ref<const string &>();
+    // parentheses are kept around negative folded results
+    if (kind == "ParenthesesExpression") {
+        auto expression = literal.find("expression");
+        return expression != literal.end() && decode(*expression, constant);
+    }
+    if (kind.size() < suffix.size() || kind.compare(kind.size() - suffix.size(), suffix.size(), suffix) != 0
+        || kind.find("Float") != string::npos) {
+        return false;
+    }
+    bool isUnsigned = kind.rfind("Unsigned", 0) == 0;
+    int longs = kind.find("LongLong") != string::npos ? 2 : kind.find("Long") != string::npos ? 1 : 0;
+    string_view text = literal["value"].get_ref<const string &>();
+    bool negative = !text.empty() && text[0] == '-';
+    if (negative) {
+        text.remove_prefix(1);
+    }
+    // the base is read from the digits rather than trusted from the kind
+    bool isHexadecimal = text.size() > 1 && text[0] == '0' && tolower(text[1]) == 'x';
+    bool isOctal = !isHexadecimal && text.size() > 1 && text[0] == '0';
+    if (isHexadecimal) {
+        text.remove_prefix(2);
+    }
+    while (!text.empty() && (tolower(text.back()) == 'u' || tolower(text.back()) == 'l')) {
+        text.remove_suffix(1);
+    }
+    uint64_t magnitude;
+    if (!Grammar::decodeInteger(text, isHexadecimal ? 16 : isOctal ? 8 : 10, magnitude)) {
+        return false;
+    }
+    // the type is the first of the candidates allowed by suffix and base that can represent the value
+    bool isDecimal = !isHexadecimal && !isOctal;
+    for (int rank = longs; rank <= 2; rank++) {
+        uint64_t all = mask(width(rank));
+        if (!isUnsigned && magnitude <= all >> 1) {
+            constant = {negative ? (0 - magnitude) & all : magnitude, rank, false};
+            return true;
+        }
+        if ((isUnsigned || !isDecimal) && magnitude <= all) {
+            constant = {negative ? (0 - magnitude) & all : magnitude, rank, true};
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Convert a constant to a type
+ * @param constant - constant
+ * @param rank - rank of type
+ * @param isUnsigned - whether type is unsigned
+ * @return - converted constant
+ */
+IntegerConstant ConstantFolder::convert(const IntegerConstant &constant, int rank, bool isUnsigned) {
+    uint64_t value = constant.isUnsigned ? constant.bits : static_cast<uint64_t>(toSigned(constant));
+    return {value & mask(width(rank)), rank, isUnsigned};
+}
+
+/**
+ * Evaluate a binary operator
+ * @param left - left operand
+ * @param op - operator
+ * @param right - right operand
+ * @param result - result
+ * @return - false if operator is not foldable or result is not defined
+ */
+bool ConstantFolder::evaluate(const IntegerConstant &left, const string &op, const IntegerConstant &right,
+                              IntegerConstant &result) {
+    if (op == "&&" || op == "||") {
+        bool isTrue = op == "&&" ? left.bits && right.bits : left.bits || right.bits;
+        result = {isTrue, 0, false};
+        return true;
+    }
+    if (op == "<<" || op == ">>") {
+        // the result has the type of left operand, a count out of its width is undefined
+        int bits = width(left.rank);
+        if (!right.isUnsigned && toSigned(right) < 0) {
+            return false;
+        }
+        uint64_t count = right.isUnsigned ? right.bits : static_cast<uint64_t>(toSigned(right));
+        if (count >= static_cast<uint64_t>(bits)) {
+            return false;
+        }
+        if (left.isUnsigned) {
+            result = {(op == "<<" ? left.bits << count : left.bits >> count) & mask(bits), left.rank, true};
+            return true;
+        }
+        int64_t value = toSigned(left);
+        if (value < 0 || (op == "<<" && static_cast<uint64_t>(value) >> (bits - 1 - count) != 0)) {
+            return false;
+        }
+        uint64_t shifted = op == "<<" ? static_cast<uint64_t>(value) << count : static_cast<uint64_t>(value) >> count;
+        result = {shifted & mask(bits), left.rank, false};
+        return true;
+    }
+    // usual arithmetic conversions
+    int rank;
+    bool isUnsigned;
+    if (left.isUnsigned == right.isUnsigned) {
+        rank = max(left.rank, right.rank);
+        isUnsigned = left.isUnsigned;
+    } else {
+        const IntegerConstant &unsignedOperand = left.isUnsigned ? left : right;
+        const IntegerConstant &signedOperand = left.isUnsigned ? right : left;
+        if (unsignedOperand.rank >= signedOperand.rank) {
+            rank = unsignedOperand.rank;
+            isUnsigned = true;
+        } else {
+            rank = signedOperand.rank;
+            isUnsigned = width(signedOperand.rank) == width(unsignedOperand.rank);
+        }
+    }
+    IntegerConstant a = convert(left, rank, isUnsigned);
+    IntegerConstant b = convert(right, rank, isUnsigned);
+    if (op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=") {
+        int order = isUnsigned ? (a.bits < b.bits ? -1 : a.bits > b.bits)
+                               : (toSigned(a) < toSigned(b) ? -1 : toSigned(a) > toSigned(b));
+        bool isTrue = op == "<" ? order < 0 : op == ">" ? order > 0 : op == "<=" ? order <= 0
+                                                                    : op == ">=" ? order >= 0
+                                                                                 : op == "==" ? order == 0 : order != 0;
+        result = {isTrue, 0, false};
+        return true;
+    }
+    uint64_t all = mask(width(rank));
+    if (op == "&" || op == "|" || op == "^") {
+        uint64_t bits = op == "&" ? a.bits & b.bits : op == "|" ? a.bits | b.bits : a.bits ^ b.bits;
+        result = {bits & all, rank, isUnsigned};
+        return true;
+    }
+    if ((op == "/" || op == "%") && b.bits == 0) {
+        return false;
+    }
+    if (isUnsigned) {
+        uint64_t bits;
+        if (op == "+") {
+            bits = a.bits + b.bits;
+        } else if (op == "-") {
+            bits = a.bits - b.bits;
+        } else if (op == "*") {
+            bits = a.bits * b.bits;
+        } else if (op == "/") {
+            bits = a.bits / b.bits;
+        } else if (op == "%") {
+            bits = a.bits % b.bits;
+        } else {
+            return false;
+        }
+        result = {bits & all, rank, true};
+        return true;
+    }
+    // signed overflow is undefined, so operands are checked before the exact result could leave the type
+    int64_t x = toSigned(a);
+    int64_t y = toSigned(b);
+    int64_t high = static_cast<int64_t>(mask(width(rank) - 1));
+    int64_t low = -high - 1;
+    int64_t value;
+    if (op == "+") {
+        if ((y > 0 && x > high - y) || (y < 0 && x < low - y)) {
+            return false;
+        }
+        value = x + y;
+    } else if (op == "-") {
+        if ((y < 0 && x > high + y) || (y > 0 && x < low + y)) {
+            return false;
+        }
+        value = x - y;
+    } else if (op == "*") {
+        if (x > 0 ? (y > 0 ? x > high / y : y < low / x) : x < 0 && (y > 0 ? x < low / y : y < 0 && x < high / y)) {
+            return false;
+        }
+        value = x * y;
+    } else if (op == "/") {
+        if (x == low && y == -1) {
+            return false;
+        }
+        value = x / y;
+    } else if (op == "%") {
+        value = y == -1 ? 0 : x % y;
+    } else {
+        return false;
+    }
+    result = {static_cast<uint64_t>(value) & all, rank, false};
+    return true;
+}
+
+/**
+ * Literal of a constant whose text has the type of constant
+ * @param constant - constant
+ * @param position - line number
+ * @param decodeNumbers - whether value is stored as "decoded"
+ * @return - JSON tree of literal, null if value has no literal of its type
+ */
+json ConstantFolder::encode(const IntegerConstant &constant, int position, bool decodeNumbers) {
+    string text;
+    json decoded;
+    if (constant.isUnsigned) {
+        text = to_string(constant.bits) + "U";
+        decoded = constant.bits;
+    } else {
+        int64_t value = toSigned(constant);
+        // the minimum is the negation of a literal too large for the type, e.g. -2147483648 is a long
+        if (value < 0 && 0 - static_cast<uint64_t>(value) > mask(width(constant.rank)) >> 1) {
+            return nullptr;
+        }
+        text = to_string(value);
+        decoded = value;
+    }
+    text += constant.rank == 2 ? "LL" : constant.rank == 1 ? "L" : "";
+    json literal = {
+            {"kind",     Grammar::numberKind(NumberBase::Decimal, constant.isUnsigned, constant.rank)},
+            {"position", position},
+            {"value",    text}
+    };
+    if (decodeNumbers) {
+        literal["decoded"] = decoded;
+    }
+    return literal;
+}
+
+/**
+ * Fold a binary expression over integer literals
+ * @param left - JSON tree of left operand
+ * @param op - operator
+ * @param right - JSON tree of right operand
+ * @param position - line number
+ * @param decodeNumbers - whether value is stored as "decoded"
+ * @return - JSON tree of literal, null if expression is not foldable
+ */
+json ConstantFolder::fold(const json &left, const string &op, const json &right, int position, bool decodeNumbers) {
+    IntegerConstant a;
+    IntegerConstant b;
+    IntegerConstant result;
+    if (!decode(left, a) || !decode(right, b) || !evaluate(a, op, b, result)) {
+        return nullptr;
+    }
+    return encode(result, position, decodeNumbers);
+}
@@ -0,0 +1,84 @@
+#ifndef PARSER_FOLDING_HPP
+#define PARSER_FOLDING_HPP
+
+#include "grammar.hpp"
+
+/**
+ * integer constant of a C type, int being 32 bits and long and long long 64 bits
+ */
+struct IntegerConstant {
+    uint64_t bits;
+    int rank;
+    bool isUnsigned;
+};
+
+/**
+ * Folding of binary expressions over integer literals with the semantics of C: literal types follow
+ * their value and suffix, operands get the usual arithmetic conversions and unsigned results wrap.
+ * Expressions whose result C leaves undefined or implementation-defined are not folded
+ */
+struct ConstantFolder {
+    /**
+     * Width of a type in bits
+     * @param rank - 0 for int, 1 for long, 2 for long long
+     * @return - width
+     */
+    static int width(int rank);
+
+    /**
+     * Value of a constant as a signed number
+     * @param constant - constant of a signed type
+     * @return - value
+     */
+    static int64_t toSigned(const IntegerConstant &constant);
+
+    /**
+     * Value and type of an integer literal
+     * @param literal - JSON tree of literal, possibly in parentheses
+     * @param constant - value and type
+     * @return - false if tree is not an integer literal or its value fits no type
+     */
+    static bool decode(const json &literal, IntegerConstant &constant);
+
+    /**
+     * Convert a constant to a type
+     * @param constant - constant
+     * @param rank - rank of type
+     * @param isUnsigned - whether type is unsigned
+     * @return - converted constant
+     */
+    static IntegerConstant convert(const IntegerConstant &constant, int rank, bool isUnsigned);
+
+    /**
+     * Evaluate a binary operator
+     * @param left - left operand
+     * @param op - operator
+     * @param right - right operand
+     * @param result - result
+     * @return - false if operator is not foldable or result is not defined
+     */
+    static bool evaluate(const IntegerConstant &left, const string &op, const IntegerConstant &right,
+                         IntegerConstant &result);
+
+    /**
+     * Literal of a constant whose text has the type of constant
+     * @param constant - constant
+     * @param position - line number
+     * @param decodeNumbers - whether value is stored as "decoded"
+     * @return - JSON tree of literal, null if value has no literal of its type
+     */
+    static json encode(const IntegerConstant &constant, int position, bool decodeNumbers);
+
+    /**
+     * Fold a binary expression over integer literals
+     * @param left - JSON tree of left operand
+     * @param op - operator
+     * @param right - JSON tree of right operand
+     * @param position - line number
+     * @param decodeNumbers - whether value is stored as "decoded"
+     * @return - JSON tree of literal, null if expression is not foldable
+     */
+    static json fold(const json &left, const string &op, const json &right, int position, bool decodeNumbers);
+};
+
+#endif //PARSER_FOLDING_HPP
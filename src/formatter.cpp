@@ -1,33 +1,136 @@
+#ifdef unix
+#include <fcntl.h>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
 #include "formatter.hpp"
+#include "loader.hpp"
 
 /**
- * Constructor of class
- * @param src - source code
+ * Constructor of worker formatting a part of program
+ * @param options - options of formatting
  */
-Formatter::Formatter(const string &src) {
-    this->src = json::parse(src);
+Formatter::Formatter(const FormatOptions &options) : options(options) {
+    this->options.threads = 1;
 }
 
+/**
+ * Constructor of class, loading AST from its text without the fields formatting does not read
+ * @param src - JSON text of AST
+ * @param options - options of formatting
+ */
+Formatter::Formatter(const string &src, const FormatOptions &options) : src(AstLoader::load(src)), options(options) {}
+
+/**
+ * Constructor of class
+ * @param tree - AST
+ * @param options - options of formatting
+ */
+Formatter::Formatter(json tree, const FormatOptions &options) : src(move(tree)), options(options) {}
+
 /**
  * Format code with indentation
  * @param indentLevel - level of indentation
  */
 void Formatter::indent(int indentLevel) {
-    if (stream.str().back() == '\n') {
-        for (int i = 0; i < indentLevel; i++) {
-            stream << "    ";
-        }
+    // the last character is read in place, copying the whole output on each call made formatting quadratic
+    if (stream.tellp() > 0 && stream.seekg(-1, ios::end) && stream.peek() == '\n') {
+        fill_n(ostreambuf_iterator<char>(stream), indentLevel * options.indent, ' ');
     }
 }
 
+/**
+ * Format the whole program
+ */
+void Formatter::render() {
+    format(src);
+}
+
 /**
  * Save result to file
  * @param filename - file to be saved
  */
 void Formatter::save(const string &filename) {
-    format(src);
-    ofstream file(filename);
-    file << stream.str();
+    render();
+    write(filename);
+}
+
+/**
+ * Format one top-level item on its own, e.g. while a program is parsed as a stream
+ * @param item - JSON tree of item
+ * @return - formatted code of item
+ */
+string Formatter::formatItem(const json &item) {
+    // top-level items do not depend on each other, so the program is the concatenation of its items
+    stream.str("");
+    format(item);
+    string code = stream.str();
+    stream.str("");
+    return code;
+}
+
+/**
+ * Get formatted result
+ * @return - formatted code
+ */
+string Formatter::result() const {
+    if (chunks.empty()) {
+        return stream.str();
+    }
+    string code;
+    for (const string &chunk: chunks) {
+        code += chunk;
+    }
+    return code;
+}
+
+/**
+ * Write formatted result to file
+ * @param filename - file to be written
+ */
+void Formatter::write(const string &filename) {
+    if (chunks.empty()) {
+        chunks.push_back(stream.str());
+    }
+#ifdef unix
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw runtime_error("Cannot write " + filename);
+    }
+    vector<iovec> buffers;
+    for (string &chunk: chunks) {
+        if (!chunk.empty()) {
+            buffers.push_back({&chunk[0], chunk.size()});
+        }
+    }
+    size_t done = 0;
+    while (done < buffers.size()) {
+        int batch = static_cast<int>(min<size_t>(buffers.size() - done, IOV_MAX));
+        ssize_t written = writev(fd, &buffers[done], batch);
+        if (written < 0) {
+            close(fd);
+            throw runtime_error("Cannot write " + filename);
+        }
+        // skip fully written buffers and shift the partially written one
+        while (done < buffers.size() && static_cast<size_t>(written) >= buffers[done].iov_len) {
+            written -= buffers[done].iov_len;
+            done++;
+        }
+        if (written > 0) {
+            buffers[done].iov_base = static_cast<char *>(buffers[done].iov_base) + written;
+            buffers[done].iov_len -= written;
+        }
+    }
+    close(fd);
+#else
+    ofstream file(filename, ios::binary);
+    for (const string &chunk: chunks) {
+        file << chunk;
+    }
+#endif
+    chunks.clear();
 }
 
 /**
@@ -37,19 +140,20 @@ void Formatter::save(const string &filename) {
  */
 void Formatter::format(const json &source, int indentLevel) {
     indent(indentLevel);
-    string kind = source["kind"];
+    const string &kind = source["kind"].get_ref<const string &>();
     if (kind == "Program") {
         formatProgram(source);
     } else if (kind == "Type") {
-        formatType(source);
+        formatType(source, indentLevel);
     } else if (kind == "FunctionDefinition" || kind == "FunctionDeclaration") {
         formatFunction(source, indentLevel, kind);
     } else if (kind == "GlobalVariableDeclaration" || kind == "GlobalVariableDefinition"
                || kind == "GlobalArrayDefinition" || kind == "GlobalArrayDeclaration"
                || kind == "ArrayDefinition" || kind == "ArrayDeclaration"
                || kind == "VariableDefinition" || kind == "VariableDeclaration"
-               || kind == "ForVariableDefinition" || kind == "ForVariableDeclaration") {
-        formatDeclaration(source, kind);
+               || kind == "ForVariableDefinition" || kind == "ForVariableDeclaration"
+               || kind == "MemberDeclaration" || kind == "ArrayMemberDeclaration") {
+        formatDeclaration(source, kind, indentLevel);
     } else if (kind.find("NumberLiteral") != string::npos) {
         formatNumber(source);
     } else if (kind == "CharLiteral") {
@@ -92,6 +196,19 @@ void Formatter::format(const json &source, int indentLevel) {
         formatPredefine(source);
     } else if (kind == "TypeDefinition") {
         formatTypedef(source);
+    } else if (kind == "StructDefinition" || kind == "UnionDefinition" || kind == "EnumDefinition"
+               || kind == "StructDeclaration" || kind == "UnionDeclaration" || kind == "EnumDeclaration") {
+        // top-level definitions are separated by blank lines like functions
+        if (indentLevel == 0) {
+            stream << "\n";
+        }
+        formatTag(source, indentLevel);
+        stream << ";";
+        if (indentLevel == 0) {
+            stream << "\n";
+        }
+    } else if (kind == "EnumMember") {
+        formatEnumMember(source);
     } else if (kind == "InlineComment") {
         formatComment(source, true);
     } else if (kind == "BlockComment") {
@@ -104,23 +221,47 @@ void Formatter::format(const json &source, int indentLevel) {
  * @param source - source code
  */
 void Formatter::formatProgram(const json &source) {
-    json body = source["body"];
-    for (const json &item: body) {
-        format(item);
+    const json &body = source["body"];
+    if (options.threads == 1 || body.size() < 2) {
+        for (const json &item: body) {
+            format(item);
+        }
+        return;
+    }
+    // top-level items are formatted with indent level 0 and do not depend on each other,
+    // so each one is rendered into its own buffer and the buffers are kept in order
+    ThreadPool pool(options.threads);
+    vector<unique_ptr<Formatter>> workers;
+    for (unsigned i = 0; i < pool.size(); i++) {
+        workers.emplace_back(new Formatter(options));
     }
+    chunks.assign(body.size() + 1, "");
+    chunks[0] = stream.str();
+    stream.str("");
+    pool.run(body.size(), [&](size_t i, unsigned worker) {
+        Formatter &formatter = *workers[worker];
+        formatter.format(body[i]);
+        chunks[i + 1] = formatter.stream.str();
+        formatter.stream.str("");
+    });
 }
 
 /**
  * Format type
  * @param source - source code
+ * @param indentLevel - level of indentation
  */
-void Formatter::formatType(const json &source) {
-    json modifiers = source["modifiers"];
-    for (const json &modifier: modifiers) {
-        stream << string(modifier) + " ";
+void Formatter::formatType(const json &source, int indentLevel) {
+    for (const json &modifier: source["modifiers"]) {
+        stream << modifier.get_ref<const string &>() << ' ';
+    }
+    auto definition = source.find("definition");
+    if (definition != source.end() && !definition->is_null()) {
+        formatTag(*definition, indentLevel);
+        stream << " ";
+        return;
     }
-    string name = source["name"];
-    stream << name + " ";
+    stream << source["name"].get_ref<const string &>() << ' ';
 }
 
 /**
@@ -134,11 +275,10 @@ void Formatter::formatFunction(const json &source, int indentLevel, const string
     format(source["type"]);
     format(source["identifier"]);
     stream << "(";
-    json params = source["parameters"];
-    for (int i = 0; i < params.size(); i++) {
-        json param = params[i];
-        string typeName = param["type"]["name"];
-        stream << typeName + " ";
+    const json &params = source["parameters"];
+    for (size_t i = 0; i < params.size(); i++) {
+        const json &param = params[i];
+        stream << param["type"]["name"].get_ref<const string &>() << ' ';
         format(param["identifier"]);
         if (i != params.size() - 1) {
             stream << ", ";
@@ -160,13 +300,34 @@ void Formatter::formatFunction(const json &source, int indentLevel, const string
  * Format declaration/definition
  * @param source - source code
  * @param kind - statement kind
+ * @param indentLevel - level of indentation
  */
-void Formatter::formatDeclaration(const json &source, const string &kind) {
-    format(source["type"]);
+void Formatter::formatDeclaration(const json &source, const string &kind, int indentLevel) {
+    format(source["type"], indentLevel);
+    formatDeclarator(source, kind);
+    // identifiers sharing an anonymous struct, union or enum
+    auto declarators = source.find("declarators");
+    if (declarators != source.end()) {
+        for (const json &declarator: *declarators) {
+            stream << ", ";
+            formatDeclarator(declarator, declarator["kind"].get_ref<const string &>());
+        }
+    }
+    stream << ";";
+    if (kind.find("Global") != string::npos) {
+        stream << "\n";
+    }
+}
+
+/**
+ * Format declared identifier with its array lengths, width and value
+ * @param source - source code
+ * @param kind - statement kind
+ */
+void Formatter::formatDeclarator(const json &source, const string &kind) {
     format(source["identifier"]);
     if (kind.find("Array") != string::npos) {
-        json lengths = source["length"];
-        for (const json &length: lengths) {
+        for (const json &length: source["length"]) {
             stream << "[";
             if (!length.is_null()) {
                 format(length);
@@ -174,14 +335,13 @@ void Formatter::formatDeclaration(const json &source, const string &kind) {
             stream << "]";
         }
     }
+    if (source.find("width") != source.end()) {
+        stream << " : ";
+        format(source["width"]);
+    }
     if (kind.find("Definition") != string::npos) {
         stream << " = ";
-        json value = source["value"];
-        format(value);
-    }
-    stream << ";";
-    if (kind.find("Global") != string::npos) {
-        stream << "\n";
+        format(source["value"]);
     }
 }
 
@@ -190,8 +350,7 @@ void Formatter::formatDeclaration(const json &source, const string &kind) {
  * @param source - source code
  */
 void Formatter::formatNumber(const json &source) {
-    string value = source["value"];
-    stream << value;
+    stream << source["value"].get_ref<const string &>();
 }
 
 /**
@@ -199,8 +358,7 @@ void Formatter::formatNumber(const json &source) {
  * @param source - source code
  */
 void Formatter::formatChar(const json &source) {
-    string value = source["value"];
-    stream << "'" + value + "'";
+    stream << '\'' << source["value"].get_ref<const string &>() << '\'';
 }
 
 /**
@@ -208,8 +366,7 @@ void Formatter::formatChar(const json &source) {
  * @param source - source code
  */
 void Formatter::formatString(const json &source) {
-    string value = source["value"];
-    stream << "\"" + value + "\"";
+    stream << '"' << source["value"].get_ref<const string &>() << '"';
 }
 
 /**
@@ -217,9 +374,9 @@ void Formatter::formatString(const json &source) {
  * @param source - source code
  */
 void Formatter::formatArray(const json &source) {
-    json values = source["value"];
+    const json &values = source["value"];
     stream << "{ ";
-    for (int i = 0; i < values.size(); i++) {
+    for (size_t i = 0; i < values.size(); i++) {
         format(values[i]);
         if (i != values.size() - 1) {
             stream << ", ";
@@ -233,12 +390,9 @@ void Formatter::formatArray(const json &source) {
  * @param source - source code
  */
 void Formatter::formatBinary(const json &source) {
-    json left = source["left"];
-    json right = source["right"];
-    string op = source["operator"];
-    format(left);
-    stream << " " + op + " ";
-    format(right);
+    format(source["left"]);
+    stream << ' ' << source["operator"].get_ref<const string &>() << ' ';
+    format(source["right"]);
 }
 
 /**
@@ -246,10 +400,8 @@ void Formatter::formatBinary(const json &source) {
  * @param source - source code
  */
 void Formatter::formatIndex(const json &source) {
-    string name = source["array"]["name"];
-    stream << name;
-    json indexes = source["indexes"];
-    for (const json &index: indexes) {
+    stream << source["array"]["name"].get_ref<const string &>();
+    for (const json &index: source["indexes"]) {
         stream << "[";
         format(index);
         stream << "]";
@@ -261,11 +413,10 @@ void Formatter::formatIndex(const json &source) {
  * @param source - source code
  */
 void Formatter::formatCall(const json &source) {
-    string name = source["callee"]["name"];
-    stream << name;
+    stream << source["callee"]["name"].get_ref<const string &>();
     stream << "(";
-    json arguments = source["arguments"];
-    for (int i = 0; i < arguments.size(); i++) {
+    const json &arguments = source["arguments"];
+    for (size_t i = 0; i < arguments.size(); i++) {
         format(arguments[i]);
         if (i != arguments.size() - 1) {
             stream << ", ";
@@ -289,8 +440,7 @@ void Formatter::formatParentheses(const json &source) {
  * @param source - source code
  */
 void Formatter::formatIdentifier(const json &source) {
-    string name = source["name"];
-    stream << name;
+    stream << source["name"].get_ref<const string &>();
 }
 
 /**
@@ -298,7 +448,7 @@ void Formatter::formatIdentifier(const json &source) {
  * @param source - source code
  */
 void Formatter::formatExpression(const json &source) {
-    json expression = source["expression"];
+    const json &expression = source["expression"];
     if (!expression.is_null()) {
         format(expression);
     }
@@ -311,7 +461,7 @@ void Formatter::formatExpression(const json &source) {
  * @param indentLevel - level of indentation
  */
 void Formatter::formatBody(const json &source, int indentLevel) {
-    json body = source["body"];
+    const json &body = source["body"];
     for (const json &item: body) {
         stream << "\n";
         format(item, indentLevel + 1);
@@ -328,7 +478,7 @@ void Formatter::formatBody(const json &source, int indentLevel) {
  */
 void Formatter::formatIf(const json &source, int indentLevel) {
     stream << "if (";
-    json condition = source["condition"];
+    const json &condition = source["condition"];
     if (!condition.is_null()) {
         format(condition);
     }
@@ -336,10 +486,10 @@ void Formatter::formatIf(const json &source, int indentLevel) {
     format(source["body"], indentLevel);
     indent(indentLevel);
     stream << "}";
-    json else_ = source["elseBody"];
-    if (!else_.is_null()) {
+    const json &elseBody = source["elseBody"];
+    if (!elseBody.is_null()) {
         stream << " else {";
-        format(source["elseBody"], indentLevel);
+        format(elseBody, indentLevel);
         indent(indentLevel);
         stream << "}";
     }
@@ -352,15 +502,14 @@ void Formatter::formatIf(const json &source, int indentLevel) {
  */
 void Formatter::formatFor(const json &source, int indentLevel) {
     stream << "for (";
-    json init = source["init"];
-    format(init);
+    format(source["init"], indentLevel);
     stream << " ";
-    json condition = source["condition"];
+    const json &condition = source["condition"];
     if (!condition.is_null()) {
         format(condition);
     }
     stream << "; ";
-    json step = source["step"];
+    const json &step = source["step"];
     if (!step.is_null()) {
         format(step);
     }
@@ -377,7 +526,7 @@ void Formatter::formatFor(const json &source, int indentLevel) {
  */
 void Formatter::formatWhile(const json &source, int indentLevel) {
     stream << "while (";
-    json condition = source["condition"];
+    const json &condition = source["condition"];
     if (!condition.is_null()) {
         format(condition);
     }
@@ -397,7 +546,7 @@ void Formatter::formatDoWhile(const json &source, int indentLevel) {
     format(source["body"], indentLevel);
     indent(indentLevel);
     stream << "} while (";
-    json condition = source["condition"];
+    const json &condition = source["condition"];
     if (!condition.is_null()) {
         format(condition);
     }
@@ -410,7 +559,7 @@ void Formatter::formatDoWhile(const json &source, int indentLevel) {
  */
 void Formatter::formatReturn(const json &source) {
     stream << "return";
-    json value = source["value"];
+    const json &value = source["value"];
     if (!value.is_null()) {
         stream << " ";
         format(value);
@@ -424,7 +573,7 @@ void Formatter::formatReturn(const json &source) {
  */
 void Formatter::formatBreak(const json &source) {
     stream << "break";
-    json label = source["label"];
+    const json &label = source["label"];
     if (!label.is_null()) {
         stream << " ";
         format(label);
@@ -438,7 +587,7 @@ void Formatter::formatBreak(const json &source) {
  */
 void Formatter::formatContinue(const json &source) {
     stream << "continue";
-    json label = source["label"];
+    const json &label = source["label"];
     if (!label.is_null()) {
         stream << " ";
         format(label);
@@ -452,8 +601,7 @@ void Formatter::formatContinue(const json &source) {
  */
 void Formatter::formatInclude(const json &source) {
     stream << "#include ";
-    string file = source["file"];
-    stream << file + "\n";
+    stream << source["file"].get_ref<const string &>() << '\n';
 }
 
 /**
@@ -462,13 +610,12 @@ void Formatter::formatInclude(const json &source) {
  */
 void Formatter::formatPredefine(const json &source) {
     stream << "#define ";
-    string identifier = source["identifier"]["name"];
-    stream << identifier;
+    stream << source["identifier"]["name"].get_ref<const string &>();
 
-    json arguments = source["arguments"];
+    const json &arguments = source["arguments"];
     if (!arguments.is_null()) {
         stream << "(";
-        for (int i = 0; i < arguments.size(); i++) {
+        for (size_t i = 0; i < arguments.size(); i++) {
             format(arguments[i]);
             if (i != arguments.size() - 1) {
                 stream << ", ";
@@ -477,8 +624,7 @@ void Formatter::formatPredefine(const json &source) {
         stream << ")";
     }
     stream << " ";
-    json value = source["value"];
-    format(value);
+    format(source["value"]);
     stream << "\n";
 }
 
@@ -494,6 +640,55 @@ void Formatter::formatTypedef(const json &source) {
     stream << ";\n";
 }
 
+/**
+ * Format struct, union or enum definition
+ * @param source - source code
+ * @param indentLevel - level of indentation
+ */
+void Formatter::formatTag(const json &source, int indentLevel) {
+    const string &kind = source["kind"].get_ref<const string &>();
+    stream << (kind.rfind("Struct", 0) == 0 ? "struct" : kind.rfind("Union", 0) == 0 ? "union" : "enum");
+    const json &identifier = source["identifier"];
+    if (!identifier.is_null()) {
+        stream << " ";
+        format(identifier);
+    }
+    if (source.find("members") == source.end()) {
+        return;
+    }
+    stream << " {";
+    const json &members = source["members"];
+    size_t enumMembers = 0;
+    for (const json &member: members) {
+        enumMembers += member["kind"] == "EnumMember";
+    }
+    for (const json &member: members) {
+        stream << "\n";
+        format(member, indentLevel + 1);
+        if (member["kind"] == "EnumMember" && --enumMembers) {
+            stream << ",";
+        }
+    }
+    if (!members.empty()) {
+        stream << "\n";
+    }
+    indent(indentLevel);
+    stream << "}";
+}
+
+/**
+ * Format enum member
+ * @param source - source code
+ */
+void Formatter::formatEnumMember(const json &source) {
+    format(source["identifier"]);
+    const json &value = source["value"];
+    if (!value.is_null()) {
+        stream << " = ";
+        format(value);
+    }
+}
+
 /**
  * Format comment
  * @param source - source code
@@ -501,7 +696,6 @@ void Formatter::formatTypedef(const json &source) {
  */
 void Formatter::formatComment(const json &source, bool isInline) {
     stream << (isInline ? "// " : "/* ");
-    string content = source["content"];
-    stream << content;
+    stream << source["content"].get_ref<const string &>();
     stream << (isInline ? "\n" : " */");
 }
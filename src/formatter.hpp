@@ -1,13 +1,42 @@
 #ifndef PARSER_FORMATTER_HPP
 #define PARSER_FORMATTER_HPP
 
+#include <algorithm>
 #include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
 #include "grammar.hpp"
+#include "pool.hpp"
+
+/**
+ * options of formatting
+ */
+struct FormatOptions {
+    /**
+     * number of threads formatting top-level items, 0 for hardware concurrency
+     */
+    unsigned threads = 1;
+
+    /**
+     * spaces per level of indentation
+     */
+    int indent = 4;
+};
 
 class Formatter {
+    friend struct Benchmark;
 
     json src;
     stringstream stream;
+    FormatOptions options;
+    vector<string> chunks;
+
+    /**
+     * Constructor of worker formatting a part of program
+     * @param options - options of formatting
+     */
+    explicit Formatter(const FormatOptions &options);
 
     /**
      * Format code with indentation
@@ -16,11 +45,19 @@ class Formatter {
     void indent(int indentLevel);
 
 public:
+    /**
+     * Constructor of class, loading AST from its text without the fields formatting does not read
+     * @param src - JSON text of AST
+     * @param options - options of formatting
+     */
+    explicit Formatter(const string &src, const FormatOptions &options = FormatOptions());
+
     /**
      * Constructor of class
-     * @param src - source code
+     * @param tree - AST
+     * @param options - options of formatting
      */
-    explicit Formatter(const string &src);
+    explicit Formatter(json tree, const FormatOptions &options = FormatOptions());
 
     /**
      * Format source code
@@ -29,6 +66,30 @@ public:
      */
     void format(const json &source, int indentLevel = 0);
 
+    /**
+     * Format the whole program
+     */
+    void render();
+
+    /**
+     * Format one top-level item on its own, e.g. while a program is parsed as a stream
+     * @param item - JSON tree of item
+     * @return - formatted code of item
+     */
+    string formatItem(const json &item);
+
+    /**
+     * Get formatted result
+     * @return - formatted code
+     */
+    string result() const;
+
+    /**
+     * Write formatted result to file
+     * @param filename - file to be written
+     */
+    void write(const string &filename);
+
     /**
      * Save result to file
      * @param filename - file to be saved
@@ -44,8 +105,9 @@ public:
     /**
      * Format type
      * @param source - source code
+     * @param indentLevel - level of indentation
      */
-    void formatType(const json &source);
+    void formatType(const json &source, int indentLevel);
 
     /**
      * Format function
@@ -59,8 +121,16 @@ public:
      * Format declaration/definition
      * @param source - source code
      * @param kind - statement kind
+     * @param indentLevel - level of indentation
+     */
+    void formatDeclaration(const json &source, const string &kind, int indentLevel);
+
+    /**
+     * Format declared identifier with its array lengths, width and value
+     * @param source - source code
+     * @param kind - statement kind
      */
-    void formatDeclaration(const json &source, const string &kind);
+    void formatDeclarator(const json &source, const string &kind);
 
     /**
      * Format number
@@ -193,6 +263,19 @@ public:
      */
     void formatTypedef(const json &source);
 
+    /**
+     * Format struct, union or enum definition
+     * @param source - source code
+     * @param indentLevel - level of indentation
+     */
+    void formatTag(const json &source, int indentLevel);
+
+    /**
+     * Format enum member
+     * @param source - source code
+     */
+    void formatEnumMember(const json &source);
+
     /**
      * Format comment
      * @param source - source code
@@ -1,3 +1,9 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <charconv>
+#include <cstring>
 #include "grammar.hpp"
 
 /**
@@ -75,6 +81,29 @@ bool Grammar::isIdentifier(basic_string<char> str) {
     return true;
 }
 
+/**
+ * Whether word is type modifier
+ * @param word - current word
+ * @return - result
+ */
+bool Grammar::isTypeModifier(string_view word) const {
+    for (const json &modifier: typeModifiers) {
+        if (modifier.get_ref<const string &>() == word) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Whether word introduces struct, union or enum type
+ * @param word - current word
+ * @return - result
+ */
+bool Grammar::isTagKeyword(string_view word) {
+    return word == "struct" || word == "union" || word == "enum";
+}
+
 /**
  * Whether current char is space
  * @param ch - current char
@@ -100,3 +129,203 @@ bool Grammar::isIllegal(char ch) {
     }
     return ch <= 31 || ch == 36 || ch == 64 || ch == 92 || ch == 96 || ch >= 127;
 }
+
+
+/**
+ * Find first double quote, backslash or end of string
+ * @param str - string to be scanned
+ * @param begin - position to start from
+ * @return - position of found character, size of str at end
+ */
+size_t Grammar::scanString(const string &str, size_t begin) {
+    size_t size = str.size();
+    const char *data = str.data();
+    size_t i = begin;
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                                     _mm_cmpeq_epi8(block, zero));
+        int mask = _mm_movemask_epi8(found);
+        if (mask) {
+            return i + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        if (data[i] == '"' || data[i] == '\\' || data[i] == 0) {
+            return i;
+        }
+    }
+    return size;
+}
+
+/**
+ * Length of escape sequence
+ * @param str - string containing escape sequence
+ * @param begin - position of backslash
+ * @return - length of escape sequence, 0 if invalid
+ */
+size_t Grammar::escapeLength(string_view str, size_t begin) {
+    size_t i = begin + 1;
+    if (i >= str.size()) {
+        return 0;
+    }
+    char ch = str[i];
+    if (ch == 'x') {
+        i++;
+        for (int digits = 0; digits < 2 && i < str.size() && isHex(str[i]); digits++) {
+            i++;
+        }
+    } else if (isOct(ch)) {
+        for (int digits = 0; digits < 3 && i < str.size() && isOct(str[i]); digits++) {
+            i++;
+        }
+    } else if (string_view("abfnrtv\\'\"?").find(ch) != string_view::npos) {
+        i++;
+    } else {
+        return 0;
+    }
+    return i - begin;
+}
+
+/**
+ * Decode escape sequences of string or char literal
+ * @param literal - literal as written in source, without quotes
+ * @return - decoded value
+ */
+string Grammar::unescape(string_view literal) {
+    size_t next = literal.find('\\');
+    if (next == string_view::npos) {
+        return string(literal);
+    }
+    static const string_view simple = "abfnrtv\\'\"?";
+    static const string_view decoded = "\a\b\f\n\r\t\v\\'\"?";
+    string value(literal.substr(0, next));
+    while (next < literal.size()) {
+        if (literal[next] != '\\') {
+            value.push_back(literal[next++]);
+            continue;
+        }
+        size_t length = escapeLength(literal, next);
+        if (length == 0) {
+            throw runtime_error("Invalid escape sequence");
+        }
+        char ch = literal[next + 1];
+        if (ch == 'x' || isOct(ch)) {
+            int code = 0;
+            for (size_t i = next + (ch == 'x' ? 2 : 1); i < next + length; i++) {
+                code = code * (ch == 'x' ? 16 : 8) + (isNumber(literal[i]) ? literal[i] - '0' : tolower(literal[i]) - 'a' + 10);
+            }
+            value.push_back(static_cast<char>(code));
+        } else {
+            value.push_back(decoded[simple.find(ch)]);
+        }
+        next += length;
+    }
+    return value;
+}
+
+/**
+ * Kind name of number literal
+ * @param base - base of literal
+ * @param isUnsigned - has unsigned suffix
+ * @param longs - number of long suffixes
+ * @return - kind name, e.g. UnsignedLongHexNumberLiteral
+ */
+const string &Grammar::numberKind(NumberBase base, bool isUnsigned, int longs) {
+    static const vector<string> names = [] {
+        vector<string> list;
+        for (const char *name: {"NumberLiteral", "HexNumberLiteral", "OctNumberLiteral", "FloatNumberLiteral"}) {
+            for (const char *sign: {"", "Unsigned"}) {
+                for (const char *size: {"", "Long", "LongLong"}) {
+                    list.push_back(string(sign) + size + name);
+                }
+            }
+        }
+        return list;
+    }();
+    return names[static_cast<size_t>(base) * 6 + isUnsigned * 3 + longs];
+}
+
+/**
+ * Value of eight decimal digits
+ * @param digits - pointer to eight digits
+ * @return - value
+ */
+uint32_t Grammar::parseEightDigits(const char *digits) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // combine adjacent digits pairwise: 8 x 1 digit -> 4 x 2 digits -> 2 x 4 digits -> 8 digits
+    uint64_t value;
+    memcpy(&value, digits, 8);
+    value = (value & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    value = (value & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return static_cast<uint32_t>((value & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32);
+#else
+    uint32_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = value * 10 + (digits[i] - '0');
+    }
+    return value;
+#endif
+}
+
+/**
+ * Decode integer literal without sign, prefix and suffix
+ * @param digits - digits of literal
+ * @param base - 8, 10 or 16
+ * @param value - decoded value
+ * @return - false if literal is malformed or overflows
+ */
+bool Grammar::decodeInteger(string_view digits, int base, uint64_t &value) {
+    if (digits.empty()) {
+        return false;
+    }
+    value = 0;
+    size_t i = 0;
+    if (base == 10) {
+        for (; i + 8 <= digits.size(); i += 8) {
+            for (size_t j = i; j < i + 8; j++) {
+                if (!isNumber(digits[j])) {
+                    return false;
+                }
+            }
+            uint64_t chunk = parseEightDigits(digits.data() + i);
+            if (value > (UINT64_MAX - chunk) / 100000000ULL) {
+                return false;
+            }
+            value = value * 100000000ULL + chunk;
+        }
+    }
+    for (; i < digits.size(); i++) {
+        char ch = digits[i];
+        int digit;
+        if (isNumber(ch)) {
+            digit = ch - '0';
+        } else if (base == 16 && isHex(ch)) {
+            digit = tolower(ch) - 'a' + 10;
+        } else {
+            return false;
+        }
+        if (digit >= base || value > (UINT64_MAX - digit) / base) {
+            return false;
+        }
+        value = value * base + digit;
+    }
+    return true;
+}
+
+/**
+ * Decode floating literal without suffix
+ * @param digits - literal
+ * @param value - decoded value
+ * @return - false if literal is malformed
+ */
+bool Grammar::decodeFloat(string_view digits, double &value) {
+    const char *end = digits.data() + digits.size();
+    auto result = from_chars(digits.data(), end, value);
+    return result.ec == errc() && result.ptr == end;
+}
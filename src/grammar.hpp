@@ -1,6 +1,8 @@
 #ifndef GRAMMAR_H
 #define GRAMMAR_H
 
+#include <cstdint>
+#include <string_view>
 #include "../lib/json.hpp"
 
 using namespace std;
@@ -37,6 +39,16 @@ struct Compare {
     }
 };
 
+/**
+ * base of number literal
+ */
+enum class NumberBase : uint8_t {
+    Decimal,
+    Hex,
+    Oct,
+    Float
+};
+
 /**
  * basic grammars
  */
@@ -92,23 +104,6 @@ struct Grammar {
         return operatorsList;
     }();
 
-    /**
-     * conversion of escapes
-     */
-    map<char, char> escapes = {
-            {'a',  '\a'},
-            {'b',  '\b'},
-            {'f',  '\f'},
-            {'n',  '\n'},
-            {'r',  '\r'},
-            {'t',  '\t'},
-            {'v',  '\v'},
-            {'\\', '\\'},
-            {'\'', '\''},
-            {'"',  '"'},
-            {'?',  '\?'}
-    };
-
     /**
      * basic types
      */
@@ -134,9 +129,7 @@ struct Grammar {
             "unsigned",
             "short",
             "long",
-            "const",
-            "struct",
-            "enum"
+            "const"
     };
 
     /**
@@ -188,6 +181,20 @@ struct Grammar {
      */
     static bool isIdentifier(string str);
 
+    /**
+     * Whether word is type modifier
+     * @param word - current word
+     * @return - result
+     */
+    bool isTypeModifier(string_view word) const;
+
+    /**
+     * Whether word introduces struct, union or enum type
+     * @param word - current word
+     * @return - result
+     */
+    static bool isTagKeyword(string_view word);
+
     /**
      * Whether current char is space
      * @param ch - current char
@@ -201,6 +208,62 @@ struct Grammar {
      * @return - result
      */
     static bool isIllegal(char ch);
+
+    /**
+     * Find first double quote, backslash or end of string
+     * @param str - string to be scanned
+     * @param begin - position to start from
+     * @return - position of found character, size of str at end
+     */
+    static size_t scanString(const string &str, size_t begin);
+
+    /**
+     * Length of escape sequence
+     * @param str - string containing escape sequence
+     * @param begin - position of backslash
+     * @return - length of escape sequence, 0 if invalid
+     */
+    static size_t escapeLength(string_view str, size_t begin);
+
+    /**
+     * Kind name of number literal
+     * @param base - base of literal
+     * @param isUnsigned - has unsigned suffix
+     * @param longs - number of long suffixes
+     * @return - kind name, e.g. UnsignedLongHexNumberLiteral
+     */
+    static const string &numberKind(NumberBase base, bool isUnsigned, int longs);
+
+    /**
+     * Value of eight decimal digits
+     * @param digits - pointer to eight digits
+     * @return - value
+     */
+    static uint32_t parseEightDigits(const char *digits);
+
+    /**
+     * Decode integer literal without sign, prefix and suffix
+     * @param digits - digits of literal
+     * @param base - 8, 10 or 16
+     * @param value - decoded value
+     * @return - false if literal is malformed or overflows
+     */
+    static bool decodeInteger(string_view digits, int base, uint64_t &value);
+
+    /**
+     * Decode floating literal without suffix
+     * @param digits - literal
+     * @param value - decoded value
+     * @return - false if literal is malformed
+     */
+    static bool decodeFloat(string_view digits, double &value);
+
+    /**
+     * Decode escape sequences of string or char literal
+     * @param literal - literal as written in source, without quotes
+     * @return - decoded value
+     */
+    static string unescape(string_view literal);
 };
 
 #endif // GRAMMAR_H
@@ -0,0 +1,187 @@
+#include <fstream>
+#include <sstream>
+#include "headers.hpp"
+
+/**
+ * Get the cache shared by all parsers
+ * @return - shared cache
+ */
+HeaderCache &HeaderCache::shared() {
+    static HeaderCache cache;
+    return cache;
+}
+
+/**
+ * FNV-1a hash of content
+ * @param content - content to be hashed
+ * @return - 64-bit hash
+ */
+uint64_t HeaderCache::hash(string_view content) {
+    uint64_t value = 14695981039346656037ull;
+    for (char ch: content) {
+        value ^= (unsigned char) ch;
+        value *= 1099511628211ull;
+    }
+    return value;
+}
+
+/**
+ * Hash of the parse options that change a parsed file, except directory which is set per file from its path
+ * @param options - options of parsing
+ * @return - 64-bit hash
+ */
+uint64_t HeaderCache::fingerprint(const ParseOptions &options) {
+    string text = to_string(options.comments) + to_string(options.decodeNumbers) + to_string(options.foldConstants)
+                  + to_string(options.expandMacros) + to_string(options.followIncludes) + " "
+                  + to_string(options.macroDepth);
+    for (const string &includePath: options.includePaths) {
+        text += "\n" + includePath;
+    }
+    return hash(text);
+}
+
+/**
+ * Check that files are unchanged, taking the new modification time and size of those touched but unchanged
+ * @param files - files to be checked
+ * @return - whether content of every file is unchanged
+ */
+bool HeaderCache::validate(vector<HeaderFile> &files) {
+    for (HeaderFile &file: files) {
+        error_code code;
+        auto modified = filesystem::last_write_time(file.path, code);
+        auto size = filesystem::file_size(file.path, code);
+        if (modified == file.modified && size == file.size) {
+            continue;
+        }
+        ifstream input(file.path, ios::binary);
+        if (!input.is_open()) {
+            return false;
+        }
+        stringstream buffer;
+        buffer << input.rdbuf();
+        if (hash(buffer.str()) != file.hash) {
+            return false;
+        }
+        file.modified = modified;
+        file.size = size;
+    }
+    return true;
+}
+
+/**
+ * Find header of #include statement in search paths
+ * @param file - file of #include statement, with quotes or angle brackets
+ * @param directory - directory of including file, searched first for quoted files
+ * @param paths - include search paths
+ * @return - path of header, empty if not found
+ */
+string HeaderCache::resolve(string_view file, const string &directory, const vector<string> &paths) {
+    if (file.size() < 2) {
+        return "";
+    }
+    filesystem::path name(file.substr(1, file.size() - 2));
+    error_code code;
+    if (file[0] == '"') {
+        filesystem::path candidate = filesystem::path(directory) / name;
+        if (filesystem::is_regular_file(candidate, code)) {
+            return candidate.lexically_normal().string();
+        }
+    }
+    for (const string &path: paths) {
+        filesystem::path candidate = filesystem::path(path) / name;
+        if (filesystem::is_regular_file(candidate, code)) {
+            return candidate.lexically_normal().string();
+        }
+    }
+    return "";
+}
+
+/**
+ * Get parsed header, parsing it if not cached or changed since
+ * @param path - path of header
+ * @param options - options of parsing
+ * @return - parsed header whose error is set if parsing failed, nullptr if header is being loaded by the caller
+ */
+shared_ptr<const Header> HeaderCache::load(const string &path, const ParseOptions &options) {
+    // headers being parsed by this thread, an #include cycle stops at the second visit
+    thread_local vector<string> loading;
+    if (find(loading.begin(), loading.end(), path) != loading.end()) {
+        return nullptr;
+    }
+    // options changing the AST are part of the key
+    string key = path;
+    key.push_back('\0');
+    key += to_string(fingerprint(options));
+    Entry cached;
+    {
+        lock_guard<mutex> guard(lock);
+        auto found = entries.find(key);
+        if (found != entries.end()) {
+            cached = found->second;
+        }
+    }
+    // validated without holding the lock, as touched files are read again
+    if (cached.header && validate(cached.files)) {
+        lock_guard<mutex> guard(lock);
+        auto found = entries.find(key);
+        if (found != entries.end() && found->second.header == cached.header) {
+            found->second.files = move(cached.files);
+        }
+        return cached.header;
+    }
+    error_code code;
+    auto modified = filesystem::last_write_time(path, code);
+    auto size = filesystem::file_size(path, code);
+    ifstream file(path, ios::binary);
+    auto header = make_shared<Header>();
+    header->path = path;
+    if (!file.is_open()) {
+        header->error = "Cannot open " + path;
+        return header;
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    string content = buffer.str();
+    header->files.push_back({path, modified, size, hash(content)});
+    // parsed without holding the lock, so headers including each other on different threads cannot deadlock
+    ParseOptions headerOptions = options;
+    headerOptions.directory = filesystem::path(path).parent_path().string();
+    loading.push_back(path);
+    try {
+        Parser parser(move(content), headerOptions);
+        header->tree = parser.parse();
+        header->typeNames = parser.typeDefinitions();
+        header->macros = parser.macros();
+        for (const shared_ptr<const Header> &included: parser.includedHeaders()) {
+            for (const HeaderFile &dependency: included->files) {
+                auto same = [&](const HeaderFile &other) { return other.path == dependency.path; };
+                if (none_of(header->files.begin(), header->files.end(), same)) {
+                    header->files.push_back(dependency);
+                }
+            }
+        }
+    } catch (exception &e) {
+        header->error = e.what();
+    }
+    loading.pop_back();
+    lock_guard<mutex> guard(lock);
+    entries[key] = Entry{header->files, header};
+    return header;
+}
+
+/**
+ * Number of cached headers
+ * @return - number of headers
+ */
+size_t HeaderCache::size() {
+    lock_guard<mutex> guard(lock);
+    return entries.size();
+}
+
+/**
+ * Drop all cached headers
+ */
+void HeaderCache::clear() {
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+}
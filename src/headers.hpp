@@ -0,0 +1,108 @@
+#ifndef PARSER_HEADERS_HPP
+#define PARSER_HEADERS_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "parser.hpp"
+
+/**
+ * file read while parsing a header, with its state when read
+ */
+struct HeaderFile {
+    string path;
+    filesystem::file_time_type modified;
+    uintmax_t size;
+    uint64_t hash;
+};
+
+/**
+ * header parsed once and shared by every file including it
+ */
+struct Header {
+    string path;
+    json tree;
+    vector<string> typeNames;
+    vector<Macro> macros;
+    /**
+     * the header itself followed by every header it includes, directly or not
+     */
+    vector<HeaderFile> files;
+    string error;
+};
+
+/**
+ * Process-wide cache of parsed headers, keyed by path and parse options and validated by modification time,
+ * size and content hash of the header and of every header it includes
+ */
+class HeaderCache {
+    struct Entry {
+        vector<HeaderFile> files;
+        shared_ptr<const Header> header;
+    };
+
+    mutex lock;
+    unordered_map<string, Entry> entries;
+
+    HeaderCache() = default;
+
+    /**
+     * Check that files are unchanged, taking the new modification time and size of those touched but unchanged
+     * @param files - files to be checked
+     * @return - whether content of every file is unchanged
+     */
+    static bool validate(vector<HeaderFile> &files);
+
+public:
+    /**
+     * Get the cache shared by all parsers
+     * @return - shared cache
+     */
+    static HeaderCache &shared();
+
+    /**
+     * FNV-1a hash of content
+     * @param content - content to be hashed
+     * @return - 64-bit hash
+     */
+    static uint64_t hash(string_view content);
+
+    /**
+     * Hash of the parse options that change a parsed file, except directory which is set per file from its path
+     * @param options - options of parsing
+     * @return - 64-bit hash
+     */
+    static uint64_t fingerprint(const ParseOptions &options);
+
+    /**
+     * Find header of #include statement in search paths
+     * @param file - file of #include statement, with quotes or angle brackets
+     * @param directory - directory of including file, searched first for quoted files
+     * @param paths - include search paths
+     * @return - path of header, empty if not found
+     */
+    static string resolve(string_view file, const string &directory, const vector<string> &paths);
+
+    /**
+     * Get parsed header, parsing it if not cached or changed since
+     * @param path - path of header
+     * @param options - options of parsing
+     * @return - parsed header whose error is set if parsing failed, nullptr if header is being loaded by the caller
+     */
+    shared_ptr<const Header> load(const string &path, const ParseOptions &options);
+
+    /**
+     * Number of cached headers
+     * @return - number of headers
+     */
+    size_t size();
+
+    /**
+     * Drop all cached headers
+     */
+    void clear();
+};
+
+#endif //PARSER_HEADERS_HPP
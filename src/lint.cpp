@@ -0,0 +1,349 @@
+#include <algorithm>
+#include "lint.hpp"
+
+/**
+ * Constructor of class
+ * @param rule - name of rule
+ */
+LintPass::LintPass(string rule) : rule(move(rule)) {}
+
+/**
+ * Report a diagnostic of the rule of pass
+ * @param position - line number
+ * @param message - description of problem
+ */
+void LintPass::report(int position, const string &message) {
+    found.push_back({rule, position, message});
+}
+
+/**
+ * Forget diagnostics of previous tree
+ * @param index - index of tree
+ */
+void LintPass::begin(const AstIndex &) {
+    found.clear();
+}
+
+/**
+ * Diagnostics of last traversal
+ * @return - diagnostics in order of traversal
+ */
+const vector<Diagnostic> &LintPass::diagnostics() const {
+    return found;
+}
+
+/**
+ * Constructor of class
+ * @param rule - name of rule
+ */
+ScopePass::ScopePass(string rule) : LintPass(move(rule)) {
+    // children are visited in key order, so body comes before parameters and for initializer,
+    // which are therefore declared from the tree when their scope opens
+    onEnter("FunctionDefinition", [this](const AstIndex &index, uint32_t node) {
+        const json &value = *index.node(node).value;
+        declare(value["identifier"], SymbolKind::Function, false);
+        enterScope();
+        for (const json &parameter: value["parameters"]) {
+            declare(parameter["identifier"], SymbolKind::Variable, true);
+        }
+    });
+    onLeave("FunctionDefinition", [this](const AstIndex &, uint32_t) { leaveScope(); });
+    onEnter("FunctionDeclaration", [this](const AstIndex &index, uint32_t node) {
+        declare((*index.node(node).value)["identifier"], SymbolKind::Function, false);
+    });
+    onEnter("ForStatement", [this](const AstIndex &index, uint32_t node) {
+        enterScope();
+        const json &init = (*index.node(node).value)["init"];
+        if (init.value("kind", "").rfind("ForVariable", 0) == 0 || init.value("kind", "").rfind("ForArray", 0) == 0) {
+            declare(init["identifier"], SymbolKind::Variable, false);
+        }
+    });
+    onLeave("ForStatement", [this](const AstIndex &, uint32_t) { leaveScope(); });
+    for (const char *kind: {"BlockStatement", "InlineStatement"}) {
+        onEnter(kind, [this](const AstIndex &, uint32_t) { enterScope(); });
+        onLeave(kind, [this](const AstIndex &, uint32_t) { leaveScope(); });
+    }
+    for (const char *kind: {"VariableDefinition", "VariableDeclaration", "ArrayDefinition", "ArrayDeclaration",
+                            "GlobalVariableDefinition", "GlobalVariableDeclaration", "GlobalArrayDefinition",
+                            "GlobalArrayDeclaration"}) {
+        onEnter(kind, [this](const AstIndex &index, uint32_t node) {
+            declare((*index.node(node).value)["identifier"], SymbolKind::Variable, false);
+        });
+    }
+    onEnter("TypeDefinition", [this](const AstIndex &index, uint32_t node) {
+        declare((*index.node(node).value)["identifier"], SymbolKind::Type, false);
+    });
+    for (const char *kind: {"EnumMember", "PredefineStatement"}) {
+        onEnter(kind, [this](const AstIndex &index, uint32_t node) {
+            declare((*index.node(node).value)["identifier"], SymbolKind::Constant, false);
+        });
+    }
+    onEnter("Identifier", [this](const AstIndex &index, uint32_t node) {
+        const AstNode &identifier = index.node(node);
+        if (identifier.parent != AstIndex::none) {
+            const json &parent = *index.node(identifier.parent).value;
+            auto field = parent.find("identifier");
+            if (field != parent.end() && &*field == identifier.value) {
+                return;
+            }
+            // member names are not ordinary identifiers
+            auto member = parent.find("operator");
+            if (member != parent.end() && (*member == "." || *member == "->") && &parent["right"] == identifier.value) {
+                return;
+            }
+        }
+        if (const Symbol *symbol = symbols.lookup((*identifier.value)["name"].get_ref<const string &>())) {
+            used(*symbol);
+        }
+    });
+}
+
+/**
+ * Declare a name in innermost scope
+ * @param identifier - JSON tree of identifier
+ * @param kind - kind of name
+ * @param isParameter - whether name is a parameter of function
+ */
+void ScopePass::declare(const json &identifier, SymbolKind kind, bool isParameter) {
+    if (!identifier.is_object()) {
+        return;
+    }
+    const string &name = identifier["name"].get_ref<const string &>();
+    const Symbol *previous = symbols.lookup(name);
+    symbols.declare(name, kind, identifier.value("position", 0));
+    const Symbol *symbol = symbols.lookup(name);
+    frames.back().push_back(symbol);
+    declared(*symbol, previous, isParameter);
+}
+
+/**
+ * Open a nested scope
+ */
+void ScopePass::enterScope() {
+    symbols.enterScope();
+    frames.emplace_back();
+}
+
+/**
+ * Close innermost scope
+ */
+void ScopePass::leaveScope() {
+    closed(frames.back());
+    frames.pop_back();
+    symbols.leaveScope();
+}
+
+/**
+ * Called after a name is declared
+ * @param symbol - declared symbol
+ * @param previous - symbol visible before declaration, nullptr if none
+ * @param isParameter - whether name is a parameter of function
+ */
+void ScopePass::declared(const Symbol &, const Symbol *, bool) {}
+
+/**
+ * Called when an identifier refers to a declared name
+ * @param symbol - symbol referred to
+ */
+void ScopePass::used(const Symbol &) {}
+
+/**
+ * Called before a scope is closed
+ * @param frame - symbols declared in scope
+ */
+void ScopePass::closed(const vector<const Symbol *> &) {}
+
+/**
+ * Open file scope
+ * @param index - index of tree
+ */
+void ScopePass::begin(const AstIndex &index) {
+    LintPass::begin(index);
+    symbols.clear();
+    frames.assign(1, {});
+}
+
+/**
+ * Close file scope
+ * @param index - index of tree
+ */
+void ScopePass::end(const AstIndex &) {
+    closed(frames.back());
+    frames.clear();
+    symbols.clear();
+}
+
+UnusedVariablePass::UnusedVariablePass() : ScopePass("unused-variable") {}
+
+void UnusedVariablePass::declared(const Symbol &symbol, const Symbol *, bool isParameter) {
+    if (symbol.depth > 0 && symbol.kind == SymbolKind::Variable && !isParameter) {
+        unused.insert(&symbol);
+    }
+}
+
+void UnusedVariablePass::used(const Symbol &symbol) {
+    unused.erase(&symbol);
+}
+
+void UnusedVariablePass::closed(const vector<const Symbol *> &frame) {
+    for (const Symbol *symbol: frame) {
+        // symbols of a closed scope are freed, so none may stay in the set
+        if (unused.erase(symbol)) {
+            report(symbol->position, "unused variable '" + string(symbol->name) + "'");
+        }
+    }
+}
+
+ShadowPass::ShadowPass() : ScopePass("shadow") {}
+
+void ShadowPass::declared(const Symbol &symbol, const Symbol *previous, bool) {
+    if (previous && symbol.depth > 0 && previous->depth < symbol.depth) {
+        report(symbol.position, "declaration of '" + string(symbol.name) + "' shadows declaration at line " +
+                                to_string(previous->position));
+    }
+}
+
+AssignmentConditionPass::AssignmentConditionPass() : LintPass("assignment-in-condition") {
+    onEnter("IfStatement", [this](const AstIndex &index, uint32_t node) {
+        check((*index.node(node).value)["condition"]);
+    });
+}
+
+/**
+ * Report assignments in a condition and in operands of its logical operators
+ * @param condition - JSON tree of condition
+ */
+void AssignmentConditionPass::check(const json &condition) {
+    if (!condition.is_object() || condition.value("kind", "") != "BinaryExpression") {
+        return;
+    }
+    const string &op = condition["operator"].get_ref<const string &>();
+    if (op == "=") {
+        report(condition.value("position", 0), "assignment used as condition, parenthesize it if intended");
+    } else if (op == "&&" || op == "||") {
+        check(condition["left"]);
+        check(condition["right"]);
+    }
+}
+
+MissingReturnPass::MissingReturnPass() : LintPass("missing-return") {
+    onEnter("FunctionDefinition", [this](const AstIndex &index, uint32_t node) {
+        const json &function = *index.node(node).value;
+        const string &name = function["identifier"]["name"].get_ref<const string &>();
+        // main returns 0 when its end is reached
+        if (function["type"]["name"] != "void" && name != "main" && !terminates(function["body"])) {
+            report(function.value("position", 0), "control reaches end of non-void function '" + name + "'");
+        }
+    });
+}
+
+/**
+ * Whether a statement never completes normally, i.e. always returns, exits or loops forever
+ * @param statement - JSON tree of statement
+ * @return - result
+ */
+bool MissingReturnPass::terminates(const json &statement) {
+    if (!statement.is_object()) {
+        return false;
+    }
+    const string &kind = statement["kind"].get_ref<const string &>();
+    if (kind == "ReturnStatement") {
+        return true;
+    } else if (kind == "BlockStatement" || kind == "InlineStatement") {
+        const json &body = statement["body"];
+        return any_of(body.begin(), body.end(), terminates);
+    } else if (kind == "IfStatement") {
+        return terminates(statement["body"]) && terminates(statement["elseBody"]);
+    } else if (kind == "DoWhileStatement") {
+        return terminates(statement["body"]) && !breaks(statement["body"]);
+    } else if (kind == "WhileStatement" || kind == "ForStatement") {
+        const json &condition = statement["condition"];
+        bool isForever = condition.is_null()
+                         || (condition["kind"] == "NumberLiteral" && condition["value"] != "0");
+        return isForever && !breaks(statement["body"]);
+    } else if (kind == "ExpressionStatement") {
+        static const vector<string> exits = {"exit", "abort", "_Exit", "quick_exit"};
+        const json &expression = statement["expression"];
+        if (expression.is_object() && expression["kind"] == "CallExpression"
+            && expression["callee"].value("kind", "") == "Identifier") {
+            const string &callee = expression["callee"]["name"].get_ref<const string &>();
+            return std::find(exits.begin(), exits.end(), callee) != exits.end();
+        }
+    }
+    return false;
+}
+
+/**
+ * Whether a statement contains a break leaving the enclosing loop
+ * @param statement - JSON tree of statement
+ * @return - result
+ */
+bool MissingReturnPass::breaks(const json &statement) {
+    if (!statement.is_object()) {
+        return false;
+    }
+    const string &kind = statement["kind"].get_ref<const string &>();
+    if (kind == "BreakStatement") {
+        return true;
+    } else if (kind == "BlockStatement" || kind == "InlineStatement") {
+        const json &body = statement["body"];
+        return any_of(body.begin(), body.end(), breaks);
+    } else if (kind == "IfStatement") {
+        return breaks(statement["body"]) || breaks(statement["elseBody"]);
+    }
+    // a break inside a nested loop leaves that loop only
+    return false;
+}
+
+LabeledInterruptPass::LabeledInterruptPass() : LintPass("labeled-interrupt") {
+    for (const char *kind: {"BreakStatement", "ContinueStatement"}) {
+        onEnter(kind, [this, kind](const AstIndex &index, uint32_t node) {
+            const json &statement = *index.node(node).value;
+            if (!statement["label"].is_null()) {
+                report(statement.value("position", 0),
+                       string(kind == string("BreakStatement") ? "break" : "continue") + " with a label expression");
+            }
+        });
+    }
+}
+
+/**
+ * Constructor of class
+ */
+Linter::Linter() {
+    passes.push_back(make_unique<UnusedVariablePass>());
+    passes.push_back(make_unique<AssignmentConditionPass>());
+    passes.push_back(make_unique<MissingReturnPass>());
+    passes.push_back(make_unique<ShadowPass>());
+    passes.push_back(make_unique<LabeledInterruptPass>());
+}
+
+/**
+ * Lint a tree
+ * @param index - index of tree
+ * @return - diagnostics of all passes ordered by line
+ */
+vector<Diagnostic> Linter::lint(const AstIndex &index) const {
+    Traversal traversal;
+    for (const auto &pass: passes) {
+        traversal.add(*pass);
+    }
+    traversal.run(index);
+    vector<Diagnostic> diagnostics;
+    for (const auto &pass: passes) {
+        diagnostics.insert(diagnostics.end(), pass->diagnostics().begin(), pass->diagnostics().end());
+    }
+    stable_sort(diagnostics.begin(), diagnostics.end(), [](const Diagnostic &a, const Diagnostic &b) {
+        return a.position < b.position;
+    });
+    return diagnostics;
+}
+
+/**
+ * Lint a tree
+ * @param tree - JSON tree of program
+ * @return - diagnostics of all passes ordered by line
+ */
+vector<Diagnostic> Linter::lint(const json &tree) const {
+    return lint(AstIndex(tree));
+}
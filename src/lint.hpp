@@ -0,0 +1,218 @@
+#ifndef PARSER_LINT_HPP
+#define PARSER_LINT_HPP
+
+#include <memory>
+#include <unordered_set>
+#include "symbols.hpp"
+#include "visitor.hpp"
+
+/**
+ * problem found by a lint pass
+ */
+struct Diagnostic {
+    string rule;
+    int position;
+    string message;
+};
+
+/**
+ * Pass reporting diagnostics of one rule
+ */
+class LintPass : public Pass {
+    string rule;
+    vector<Diagnostic> found;
+
+protected:
+    /**
+     * Report a diagnostic of the rule of pass
+     * @param position - line number
+     * @param message - description of problem
+     */
+    void report(int position, const string &message);
+
+public:
+    /**
+     * Constructor of class
+     * @param rule - name of rule
+     */
+    explicit LintPass(string rule);
+
+    /**
+     * Forget diagnostics of previous tree
+     * @param index - index of tree
+     */
+    void begin(const AstIndex &index) override;
+
+    /**
+     * Diagnostics of last traversal
+     * @return - diagnostics in order of traversal
+     */
+    const vector<Diagnostic> &diagnostics() const;
+};
+
+/**
+ * Pass following declarations through scopes of functions, blocks and for statements
+ */
+class ScopePass : public LintPass {
+    SymbolTable symbols;
+    vector<vector<const Symbol *>> frames;
+
+    /**
+     * Declare a name in innermost scope
+     * @param identifier - JSON tree of identifier
+     * @param kind - kind of name
+     * @param isParameter - whether name is a parameter of function
+     */
+    void declare(const json &identifier, SymbolKind kind, bool isParameter);
+
+    /**
+     * Open a nested scope
+     */
+    void enterScope();
+
+    /**
+     * Close innermost scope
+     */
+    void leaveScope();
+
+protected:
+    /**
+     * Called after a name is declared
+     * @param symbol - declared symbol
+     * @param previous - symbol visible before declaration, nullptr if none
+     * @param isParameter - whether name is a parameter of function
+     */
+    virtual void declared(const Symbol &symbol, const Symbol *previous, bool isParameter);
+
+    /**
+     * Called when an identifier refers to a declared name
+     * @param symbol - symbol referred to
+     */
+    virtual void used(const Symbol &symbol);
+
+    /**
+     * Called before a scope is closed
+     * @param frame - symbols declared in scope
+     */
+    virtual void closed(const vector<const Symbol *> &frame);
+
+public:
+    /**
+     * Constructor of class
+     * @param rule - name of rule
+     */
+    explicit ScopePass(string rule);
+
+    /**
+     * Open file scope
+     * @param index - index of tree
+     */
+    void begin(const AstIndex &index) override;
+
+    /**
+     * Close file scope
+     * @param index - index of tree
+     */
+    void end(const AstIndex &index) override;
+};
+
+/**
+ * Local variables never referred to
+ */
+class UnusedVariablePass : public ScopePass {
+    unordered_set<const Symbol *> unused;
+
+protected:
+    void declared(const Symbol &symbol, const Symbol *previous, bool isParameter) override;
+
+    void used(const Symbol &symbol) override;
+
+    void closed(const vector<const Symbol *> &frame) override;
+
+public:
+    UnusedVariablePass();
+};
+
+/**
+ * Local declarations hiding a name of an enclosing scope
+ */
+class ShadowPass : public ScopePass {
+protected:
+    void declared(const Symbol &symbol, const Symbol *previous, bool isParameter) override;
+
+public:
+    ShadowPass();
+};
+
+/**
+ * Assignment used as condition of if statement, e.g. if (x = 0), unless it is parenthesized
+ */
+class AssignmentConditionPass : public LintPass {
+    /**
+     * Report assignments in a condition and in operands of its logical operators
+     * @param condition - JSON tree of condition
+     */
+    void check(const json &condition);
+
+public:
+    AssignmentConditionPass();
+};
+
+/**
+ * Function returning a value whose end can be reached without return statement
+ */
+class MissingReturnPass : public LintPass {
+    /**
+     * Whether a statement never completes normally, i.e. always returns, exits or loops forever
+     * @param statement - JSON tree of statement
+     * @return - result
+     */
+    static bool terminates(const json &statement);
+
+    /**
+     * Whether a statement contains a break leaving the enclosing loop
+     * @param statement - JSON tree of statement
+     * @return - result
+     */
+    static bool breaks(const json &statement);
+
+public:
+    MissingReturnPass();
+};
+
+/**
+ * Break or continue statement followed by an expression, which C does not allow
+ */
+class LabeledInterruptPass : public LintPass {
+public:
+    LabeledInterruptPass();
+};
+
+/**
+ * Suite of all lint passes, run together in one traversal of a tree
+ */
+class Linter {
+    vector<unique_ptr<LintPass>> passes;
+
+public:
+    /**
+     * Constructor of class
+     */
+    Linter();
+
+    /**
+     * Lint a tree
+     * @param index - index of tree
+     * @return - diagnostics of all passes ordered by line
+     */
+    vector<Diagnostic> lint(const AstIndex &index) const;
+
+    /**
+     * Lint a tree
+     * @param tree - JSON tree of program
+     * @return - diagnostics of all passes ordered by line
+     */
+    vector<Diagnostic> lint(const json &tree) const;
+};
+
+#endif //PARSER_LINT_HPP
@@ -0,0 +1,354 @@
+#include <charconv>
+#include <cstring>
+#include "loader.hpp"
+
+/**
+ * Constructor of class
+ * @param text - JSON text of AST
+ */
+AstLoader::AstLoader(string_view text) : text(text), position(0) {}
+
+/**
+ * Whether a field is not read by formatting
+ * @param key - name of field
+ * @return - result
+ */
+bool AstLoader::isIgnored(const string &key) {
+    return key == "position" || key == "decoded" || key == "path";
+}
+
+/**
+ * Error at current position
+ * @param expected - expected text
+ * @return - error
+ */
+runtime_error AstLoader::unexpected(const string &expected) const {
+    return runtime_error("Invalid AST at offset " + to_string(position) + ": expected " + expected);
+}
+
+/**
+ * Skip whitespace
+ */
+void AstLoader::skipSpaces() {
+    while (position < text.size()
+           && (text[position] == ' ' || text[position] == '\n' || text[position] == '\r' || text[position] == '\t')) {
+        position++;
+    }
+}
+
+/**
+ * Consume a character after whitespace
+ * @param ch - expected character
+ */
+void AstLoader::expect(char ch) {
+    skipSpaces();
+    if (position >= text.size() || text[position] != ch) {
+        throw unexpected("'"s + ch + "'");
+    }
+    position++;
+}
+
+/**
+ * Read a value
+ * @return - JSON value
+ */
+json AstLoader::readValue() {
+    skipSpaces();
+    if (position >= text.size()) {
+        throw unexpected("value");
+    }
+    switch (text[position]) {
+        case '{':
+            position++;
+            return readObject();
+        case '[':
+            position++;
+            return readArray();
+        case '"':
+            position++;
+            return readString();
+        case 't':
+        case 'f':
+        case 'n':
+            for (const char *literal: {"true", "false", "null"}) {
+                if (text.compare(position, strlen(literal), literal) == 0) {
+                    position += strlen(literal);
+                    return literal[0] == 'n' ? json() : json(literal[0] == 't');
+                }
+            }
+            throw unexpected("value");
+        default:
+            return readNumber();
+    }
+}
+
+/**
+ * Read an object after its opening brace
+ * @return - JSON object
+ */
+json AstLoader::readObject() {
+    json value = json::object();
+    auto &object = value.get_ref<json::object_t &>();
+    skipSpaces();
+    if (position < text.size() && text[position] == '}') {
+        position++;
+        return value;
+    }
+    while (true) {
+        expect('"');
+        string key = readString();
+        expect(':');
+        if (isIgnored(key)) {
+            skipValue();
+        } else {
+            // a key greater than all others goes to the end in constant time, a repeated one keeps its last value
+            object.insert_or_assign(object.end(), move(key), readValue());
+        }
+        skipSpaces();
+        if (position >= text.size() || text[position] != ',') {
+            expect('}');
+            return value;
+        }
+        position++;
+    }
+}
+
+/**
+ * Read an array after its opening bracket
+ * @return - JSON array
+ */
+json AstLoader::readArray() {
+    json value = json::array();
+    auto &array = value.get_ref<json::array_t &>();
+    skipSpaces();
+    if (position < text.size() && text[position] == ']') {
+        position++;
+        return value;
+    }
+    while (true) {
+        array.push_back(readValue());
+        skipSpaces();
+        if (position >= text.size() || text[position] != ',') {
+            expect(']');
+            return value;
+        }
+        position++;
+    }
+}
+
+/**
+ * Read a string after its opening quote
+ * @return - decoded string
+ */
+string AstLoader::readString() {
+    string value;
+    while (true) {
+        // runs without escapes are copied at once
+        size_t end = position;
+        while (end < text.size() && text[end] != '"' && text[end] != '\\' && static_cast<unsigned char>(text[end]) >= 0x20) {
+            end++;
+        }
+        value.append(text, position, end - position);
+        position = end;
+        if (position >= text.size() || static_cast<unsigned char>(text[position]) < 0x20) {
+            throw unexpected("'\"'");
+        }
+        if (text[position++] == '"') {
+            return value;
+        }
+        if (position >= text.size()) {
+            throw unexpected("escape sequence");
+        }
+        char escape = text[position++];
+        switch (escape) {
+            case '"':
+            case '\\':
+            case '/':
+                value.push_back(escape);
+                break;
+            case 'b':
+                value.push_back('\b');
+                break;
+            case 'f':
+                value.push_back('\f');
+                break;
+            case 'n':
+                value.push_back('\n');
+                break;
+            case 'r':
+                value.push_back('\r');
+                break;
+            case 't':
+                value.push_back('\t');
+                break;
+            case 'u': {
+                unsigned codePoint = readHex();
+                if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                    throw unexpected("high surrogate");
+                }
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    if (text.compare(position, 2, "\\u") != 0) {
+                        throw unexpected("low surrogate");
+                    }
+                    position += 2;
+                    unsigned low = readHex();
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        throw unexpected("low surrogate");
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                // UTF-8 encoding of code point
+                if (codePoint < 0x80) {
+                    value.push_back(static_cast<char>(codePoint));
+                } else if (codePoint < 0x800) {
+                    value.push_back(static_cast<char>(0xC0 | codePoint >> 6));
+                    value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                } else if (codePoint < 0x10000) {
+                    value.push_back(static_cast<char>(0xE0 | codePoint >> 12));
+                    value.push_back(static_cast<char>(0x80 | (codePoint >> 6 & 0x3F)));
+                    value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                } else {
+                    value.push_back(static_cast<char>(0xF0 | codePoint >> 18));
+                    value.push_back(static_cast<char>(0x80 | (codePoint >> 12 & 0x3F)));
+                    value.push_back(static_cast<char>(0x80 | (codePoint >> 6 & 0x3F)));
+                    value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                }
+                break;
+            }
+            default:
+                position--;
+                throw unexpected("escape sequence");
+        }
+    }
+}
+
+/**
+ * Read four hexadecimal digits of an escape sequence
+ * @return - code unit
+ */
+unsigned AstLoader::readHex() {
+    unsigned value = 0;
+    if (position + 4 > text.size()
+        || from_chars(text.data() + position, text.data() + position + 4, value, 16).ptr != text.data() + position + 4) {
+        throw unexpected("four hexadecimal digits");
+    }
+    position += 4;
+    return value;
+}
+
+/**
+ * Read a number
+ * @return - JSON number, unsigned if it is a nonnegative integer as with json::parse
+ */
+json AstLoader::readNumber() {
+    size_t begin = position;
+    bool isInteger = true;
+    if (position < text.size() && text[position] == '-') {
+        position++;
+    }
+    auto digits = [&] {
+        size_t first = position;
+        while (position < text.size() && isdigit(static_cast<unsigned char>(text[position]))) {
+            position++;
+        }
+        if (position == first) {
+            throw unexpected("digit");
+        }
+    };
+    if (position < text.size() && text[position] == '0') {
+        position++;
+    } else {
+        digits();
+    }
+    if (position < text.size() && text[position] == '.') {
+        position++;
+        isInteger = false;
+        digits();
+    }
+    if (position < text.size() && (text[position] == 'e' || text[position] == 'E')) {
+        position++;
+        isInteger = false;
+        if (position < text.size() && (text[position] == '+' || text[position] == '-')) {
+            position++;
+        }
+        digits();
+    }
+    const char *first = text.data() + begin;
+    const char *last = text.data() + position;
+    if (isInteger) {
+        // integers out of 64 bits are read as floating point numbers
+        if (*first == '-') {
+            int64_t value;
+            if (from_chars(first, last, value).ec == errc()) {
+                return value;
+            }
+        } else {
+            uint64_t value;
+            if (from_chars(first, last, value).ec == errc()) {
+                return value;
+            }
+        }
+    }
+    double value;
+    if (from_chars(first, last, value).ec != errc()) {
+        position = begin;
+        throw unexpected("number in range of double");
+    }
+    return value;
+}
+
+/**
+ * Skip a value without decoding it
+ */
+void AstLoader::skipValue() {
+    skipSpaces();
+    if (position >= text.size()) {
+        throw unexpected("value");
+    }
+    if (text[position] != '{' && text[position] != '[' && text[position] != '"') {
+        readValue();
+        return;
+    }
+    // strings are stepped over so that brackets in them are not counted
+    int depth = 0;
+    do {
+        char ch = text[position++];
+        if (ch == '{' || ch == '[') {
+            depth++;
+        } else if (ch == '}' || ch == ']') {
+            depth--;
+        } else if (ch == '"') {
+            while (position < text.size() && text[position] != '"') {
+                position += text[position] == '\\' ? 2 : 1;
+            }
+            if (position++ >= text.size()) {
+                throw unexpected("'\"'");
+            }
+        }
+    } while (depth > 0 && position < text.size());
+    if (depth > 0) {
+        throw unexpected("end of value");
+    }
+}
+
+/**
+ * Load an AST
+ * @return - JSON tree of AST without the fields formatting does not read
+ */
+json AstLoader::load() {
+    json value = readValue();
+    skipSpaces();
+    if (position < text.size()) {
+        throw unexpected("end of input");
+    }
+    return value;
+}
+
+/**
+ * Load an AST
+ * @param text - JSON text of AST
+ * @return - JSON tree of AST without the fields formatting does not read
+ */
+json AstLoader::load(string_view text) {
+    return AstLoader(text).load();
+}
@@ -0,0 +1,107 @@
+#ifndef PARSER_LOADER_HPP
+#define PARSER_LOADER_HPP
+
+#include <stdexcept>
+#include <string_view>
+#include "../lib/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * Loader of an AST from its JSON text for formatting, reading the text in one pass straight into the tree.
+ * Fields that formatting does not read are skipped without being decoded, and members written
+ * in key order, as dump writes them, are appended to their object without a search
+ */
+class AstLoader {
+    string_view text;
+    size_t position;
+
+    /**
+     * Whether a field is not read by formatting
+     * @param key - name of field
+     * @return - result
+     */
+    static bool isIgnored(const string &key);
+
+    /**
+     * Error at current position
+     * @param expected - expected text
+     * @return - error
+     */
+    runtime_error unexpected(const string &expected) const;
+
+    /**
+     * Skip whitespace
+     */
+    void skipSpaces();
+
+    /**
+     * Consume a character after whitespace
+     * @param ch - expected character
+     */
+    void expect(char ch);
+
+    /**
+     * Read a value
+     * @return - JSON value
+     */
+    json readValue();
+
+    /**
+     * Read an object after its opening brace
+     * @return - JSON object
+     */
+    json readObject();
+
+    /**
+     * Read an array after its opening bracket
+     * @return - JSON array
+     */
+    json readArray();
+
+    /**
+     * Read a string after its opening quote
+     * @return - decoded string
+     */
+    string readString();
+
+    /**
+     * Read four hexadecimal digits of an escape sequence
+     * @return - code unit
+     */
+    unsigned readHex();
+
+    /**
+     * Read a number
+     * @return - JSON number, unsigned if it is a nonnegative integer as with json::parse
+     */
+    json readNumber();
+
+    /**
+     * Skip a value without decoding it
+     */
+    void skipValue();
+
+public:
+    /**
+     * Constructor of class
+     * @param text - JSON text of AST
+     */
+    explicit AstLoader(string_view text);
+
+    /**
+     * Load an AST
+     * @return - JSON tree of AST without the fields formatting does not read
+     */
+    json load();
+
+    /**
+     * Load an AST
+     * @param text - JSON text of AST
+     * @return - JSON tree of AST without the fields formatting does not read
+     */
+    static json load(string_view text);
+};
+
+#endif //PARSER_LOADER_HPP
@@ -2,23 +2,124 @@
 #include <windows.h>
 #endif
 
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
-#include <chrono>
-#include "parser.cpp"
-#include "formatter.cpp"
-#include "grammar.cpp"
+#include <new>
+#include "cparser.hpp"
+#include "metrics.hpp"
 
-using namespace std::chrono;
+/**
+ * number of heap allocations of the process
+ */
+static atomic<long long> allocations(0);
 
-long getTime() {
-    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+void *operator new(size_t size) {
+    allocations++;
+    if (void *pointer = malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+/**
+ * Format nanoseconds as milliseconds
+ * @param nanoseconds - elapsed time
+ * @return - milliseconds with 3 decimals
+ */
+string toMilliseconds(long long nanoseconds) {
+    stringstream stream;
+    stream << fixed << setprecision(3) << nanoseconds / 1e6;
+    return stream.str();
 }
 
-int main() {
+/**
+ * Parse a file as a stream, writing AST and formatted code item by item
+ * @param input - input file
+ * @param options - options of parsing
+ * @param metrics - metrics receiving counters
+ */
+void streamFile(istream &input, const ParseOptions &options, Metrics &metrics) {
+    Parser parser("", options);
+    Formatter formatter(json(), FormatOptions{1});
+    ofstream astFile("ast.json");
+    ofstream formattedFile("formatted.c");
+    JsonWriter writer(astFile, 2);
+    long long nodes = 1;
+    size_t items = 0;
+    // same text as dump(2) of the whole program, items being values at the third level
+    writer.raw("{\n  \"body\": ");
+    parser.parse(input, [&](json &item) {
+        writer.raw(items++ ? ",\n    " : "[\n    ");
+        writer.write(item, 2);
+        formattedFile << formatter.formatItem(item);
+        nodes += Metrics::countNodes(item);
+    });
+    writer.raw(items ? "\n  ]" : "null");
+    writer.raw(",\n  \"kind\": \"Program\"\n}");
+    writer.flush();
+    if (!astFile || !formattedFile) {
+        throw runtime_error("Cannot write output");
+    }
+    metrics.count("tokens", parser.stats().tokens);
+    metrics.count("backtracks", parser.stats().backtracks);
+    metrics.count("nodes", nodes);
+}
+
+int main(int argc, char *argv[]) {
 #ifdef _WIN32
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
 #endif
+    string filename;
+    string statsFormat;
+    ParseOptions parseOptions;
+    bool crossReference = false;
+    bool lint = false;
+    bool streaming = false;
+    vector<string> selectors;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--stats") {
+            statsFormat = "table";
+        } else if (arg.rfind("--stats=", 0) == 0) {
+            statsFormat = arg.substr(8);
+        } else if (arg == "--expand-macros") {
+            parseOptions.expandMacros = true;
+        } else if (arg == "--fold-constants") {
+            parseOptions.foldConstants = true;
+        } else if (arg == "--query" && i + 1 < argc) {
+            selectors.emplace_back(argv[++i]);
+        } else if (arg == "--xref") {
+            crossReference = true;
+        } else if (arg == "--lint") {
+            lint = true;
+        } else if (arg == "--stream") {
+            streaming = true;
+        } else if (arg == "--follow-includes") {
+            parseOptions.followIncludes = true;
+        } else if (arg == "-I" && i + 1 < argc) {
+            parseOptions.includePaths.emplace_back(argv[++i]);
+        } else if (arg.rfind("-I", 0) == 0) {
+            parseOptions.includePaths.push_back(arg.substr(2));
+        } else {
+            filename = arg;
+        }
+    }
+    bool interactive = filename.empty();
     try {
+        if (!statsFormat.empty() && statsFormat != "table" && statsFormat != "json") {
+            throw runtime_error("Unknown stats format " + statsFormat);
+        }
 #ifdef unix
         cout << "\033[1;31m   ____   ____                          \033[0m\n"
                 "\033[1;32m  / ___| |  _ \\ __ _ _ __ ___  ___ _ __ \033[0m\n"
@@ -48,49 +149,129 @@ int main() {
         cout << "Please input path of your C file:\n";
         SetConsoleTextAttribute(hConsole, 15);
 #endif
-        string filename;
-        cin >> filename;
+        if (interactive) {
+            cin >> filename;
+        }
+        Metrics metrics;
+        long long allocationsBefore = allocations;
+        PhaseTimer readTimer(metrics, "read");
+        parseOptions.directory = filesystem::path(filename).parent_path().string();
+        if (parseOptions.directory.empty()) {
+            parseOptions.directory = ".";
+        }
         ifstream inputFile(filename);
         if (!inputFile.good()) {
             throw runtime_error("File doesn't exist!"s);
         }
-        string line;
-        string code;
-        while (getline(inputFile, line)) {
-            code += line;
-            code.push_back('\n');
-        }
-        long beforeParse = getTime();
-        string parsed = Parser(code).parse().dump(2);
-        long afterParse = getTime();
-        ofstream outputFile("ast.json");
-        outputFile << parsed;
+        if (streaming) {
+            if (crossReference || lint || !selectors.empty()) {
+                throw runtime_error("--stream cannot be combined with --xref, --query or --lint"s);
+            }
+            readTimer.stop();
+            PhaseTimer streamTimer(metrics, "stream");
+            streamFile(inputFile, parseOptions, metrics);
+            streamTimer.stop();
+            metrics.count("allocations", allocations - allocationsBefore);
 #ifdef unix
-        cout << "\033[1;32m\nParsed successfully!\033[0m\n"
-                "\033[1;33mAST is stored in \"ast.json\"\033[0m\n";
+            cout << "\033[1;32m\nParsed and formatted as a stream!\033[0m\n"
+                    "\033[1;33mAST is stored in \"ast.json\", formatted code in \"formatted.c\"\033[0m\n";
 #elif defined(_WIN32)
-        SetConsoleTextAttribute(hConsole, 10);
-        cout << "\nParsed successfully!\n";
-        SetConsoleTextAttribute(hConsole, 14);
-        cout << "AST is stored in \"ast.json\"\n";
-        SetConsoleTextAttribute(hConsole, 15);
+            SetConsoleTextAttribute(hConsole, 10);
+            cout << "\nParsed and formatted as a stream!\n";
+            SetConsoleTextAttribute(hConsole, 14);
+            cout << "AST is stored in \"ast.json\", formatted code in \"formatted.c\"\n";
+            SetConsoleTextAttribute(hConsole, 15);
 #endif
-        cout << "Parsing took " << afterParse - beforeParse << "ms\n";
-        long beforeFormat = getTime();
-        Formatter formatter(parsed);
-        formatter.save("formatted.c");
-        long afterFormat = getTime();
+            cout << "Streaming took " << toMilliseconds(metrics.elapsed("stream")) << "ms\n";
+        } else {
+            string line;
+            string code;
+            while (getline(inputFile, line)) {
+                code += line;
+                code.push_back('\n');
+            }
+            readTimer.stop();
+            metrics.count("bytes", code.size());
+            Parser parser(code, parseOptions);
+            PhaseTimer parseTimer(metrics, "lex+parse");
+            json tree = parser.parse();
+            parseTimer.stop();
+            if (lint) {
+                // lint while the tree is still hot in cache, before it is serialized
+                PhaseTimer lintTimer(metrics, "lint");
+                vector<Diagnostic> diagnostics = Linter().lint(tree);
+                lintTimer.stop();
+                for (const Diagnostic &diagnostic: diagnostics) {
+                    cout << filename << ":" << diagnostic.position << ": warning: " << diagnostic.message << " ["
+                         << diagnostic.rule << "]\n";
+                }
+                metrics.count("diagnostics", diagnostics.size());
+            }
+            // the tree is written as it is serialized, without its whole text in memory
+            PhaseTimer serializeTimer(metrics, "serialize");
+            ofstream outputFile("ast.json");
+            JsonWriter(outputFile, 2).write(tree);
+            outputFile.close();
+            serializeTimer.stop();
+            metrics.count("tokens", parser.stats().tokens);
+            metrics.count("backtracks", parser.stats().backtracks);
+            metrics.count("nodes", Metrics::countNodes(tree));
+            if (crossReference) {
+                PhaseTimer xrefTimer(metrics, "xref");
+                CrossReference index(tree);
+                ofstream xrefFile("xref.json");
+                JsonWriter(xrefFile, 2).write(index.toJson());
+                xrefFile.close();
+                xrefTimer.stop();
+            }
+            if (!selectors.empty()) {
+                PhaseTimer queryTimer(metrics, "query");
+                AstIndex index(tree);
+                for (const string &selector: selectors) {
+                    for (uint32_t node: index.select(selector)) {
+                        const json &value = *index.node(node).value;
+                        cout << filename << ":" << value.value("position", 0) << ": " << value["kind"].get<string>() << "\n";
+                    }
+                }
+                queryTimer.stop();
+            }
 #ifdef unix
-        cout << "\033[1;32m\nFormatted successfully!\033[0m\n"
-                "\033[1;33mFormatted code is stored in \"formatted.c\"\033[0m\n";
+            cout << "\033[1;32m\nParsed successfully!\033[0m\n"
+                    "\033[1;33mAST is stored in \"ast.json\"\033[0m\n";
 #elif defined(_WIN32)
-        SetConsoleTextAttribute(hConsole, 10);
-        cout << "\nFormatted successfully!\n";
-        SetConsoleTextAttribute(hConsole, 14);
-        cout << "Formatted code is stored in \"formatted.c\"\n";
-        SetConsoleTextAttribute(hConsole, 15);
+            SetConsoleTextAttribute(hConsole, 10);
+            cout << "\nParsed successfully!\n";
+            SetConsoleTextAttribute(hConsole, 14);
+            cout << "AST is stored in \"ast.json\"\n";
+            SetConsoleTextAttribute(hConsole, 15);
+#endif
+            cout << "Parsing took " << toMilliseconds(metrics.elapsed("lex+parse") + metrics.elapsed("serialize"))
+                 << "ms\n";
+            Formatter formatter(move(tree), FormatOptions{0});
+            PhaseTimer formatTimer(metrics, "format");
+            formatter.render();
+            formatTimer.stop();
+            PhaseTimer saveTimer(metrics, "write");
+            formatter.write("formatted.c");
+            saveTimer.stop();
+            metrics.count("allocations", allocations - allocationsBefore);
+#ifdef unix
+            cout << "\033[1;32m\nFormatted successfully!\033[0m\n"
+                    "\033[1;33mFormatted code is stored in \"formatted.c\"\033[0m\n";
+#elif defined(_WIN32)
+            SetConsoleTextAttribute(hConsole, 10);
+            cout << "\nFormatted successfully!\n";
+            SetConsoleTextAttribute(hConsole, 14);
+            cout << "Formatted code is stored in \"formatted.c\"\n";
+            SetConsoleTextAttribute(hConsole, 15);
 #endif
-        cout << "Formatting took " << afterFormat - beforeFormat << "ms\n";
+            cout << "Formatting took " << toMilliseconds(metrics.elapsed("format")) << "ms\n";
+        }
+        if (statsFormat == "table") {
+            cout << "\n" << metrics.table();
+        } else if (statsFormat == "json") {
+            cout << "\n" << metrics.toJson().dump(2) << "\n";
+        }
     } catch (exception &e) {
 #ifdef unix
         cout << "\033[1;31m"s + e.what() + "\033[0m\n";
@@ -100,12 +281,14 @@ int main() {
         SetConsoleTextAttribute(hConsole, 15);
 #endif
     }
+    if (interactive) {
 #ifdef _WIN32
-    system("pause");
+        system("pause");
 #else
-    cin.ignore();
-    cout << "Press any key to continue ...\n";
-    cin.get();
+        cin.ignore();
+        cout << "Press any key to continue ...\n";
+        cin.get();
 #endif
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <iomanip>
+#include <sstream>
+#include "metrics.hpp"
+
+/**
+ * Add elapsed time to a phase
+ * @param phase - name of phase
+ * @param nanoseconds - elapsed time
+ */
+void Metrics::record(const string &phase, long long nanoseconds) {
+    for (auto &entry: phases) {
+        if (entry.first == phase) {
+            entry.second += nanoseconds;
+            return;
+        }
+    }
+    phases.emplace_back(phase, nanoseconds);
+}
+
+/**
+ * Add value to a counter
+ * @param counter - name of counter
+ * @param value - value to be added
+ */
+void Metrics::count(const string &counter, long long value) {
+    for (auto &entry: counters) {
+        if (entry.first == counter) {
+            entry.second += value;
+            return;
+        }
+    }
+    counters.emplace_back(counter, value);
+}
+
+/**
+ * Elapsed time of a phase
+ * @param phase - name of phase
+ * @return - nanoseconds, 0 if never recorded
+ */
+long long Metrics::elapsed(const string &phase) const {
+    for (const auto &entry: phases) {
+        if (entry.first == phase) {
+            return entry.second;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Count AST nodes of a tree
+ * @param tree - JSON tree
+ * @return - number of nodes
+ */
+long long Metrics::countNodes(const json &tree) {
+    long long nodes = 0;
+    if (tree.is_object()) {
+        if (tree.find("kind") != tree.end()) {
+            nodes++;
+        }
+        for (const json &child: tree) {
+            nodes += countNodes(child);
+        }
+    } else if (tree.is_array()) {
+        for (const json &child: tree) {
+            nodes += countNodes(child);
+        }
+    }
+    return nodes;
+}
+
+/**
+ * Dump metrics as human readable table
+ * @return - table
+ */
+string Metrics::table() const {
+    stringstream stream;
+    stream << left << setw(20) << "Phase" << right << setw(16) << "Time (ms)" << "\n";
+    long long total = 0;
+    for (const auto &entry: phases) {
+        stream << left << setw(20) << entry.first << right << setw(16) << fixed << setprecision(3)
+               << entry.second / 1e6 << "\n";
+        total += entry.second;
+    }
+    stream << left << setw(20) << "total" << right << setw(16) << fixed << setprecision(3) << total / 1e6 << "\n";
+    stream << "\n" << left << setw(20) << "Counter" << right << setw(16) << "Value" << "\n";
+    for (const auto &entry: counters) {
+        stream << left << setw(20) << entry.first << right << setw(16) << entry.second << "\n";
+    }
+    return stream.str();
+}
+
+/**
+ * Dump metrics as JSON
+ * @return - JSON of phases in nanoseconds and counters
+ */
+json Metrics::toJson() const {
+    json result = {
+            {"phases",   json::object()},
+            {"counters", json::object()},
+    };
+    for (const auto &entry: phases) {
+        result["phases"][entry.first] = entry.second;
+    }
+    for (const auto &entry: counters) {
+        result["counters"][entry.first] = entry.second;
+    }
+    return result;
+}
+
+/**
+ * Constructor of class, starts the timer
+ * @param metrics - metrics to record into
+ * @param phase - name of phase
+ */
+PhaseTimer::PhaseTimer(Metrics &metrics, string phase)
+        : metrics(metrics), phase(move(phase)), start(chrono::steady_clock::now()), running(true) {}
+
+/**
+ * Destructor of class, stops the timer
+ */
+PhaseTimer::~PhaseTimer() {
+    stop();
+}
+
+/**
+ * Stop the timer and record elapsed time
+ */
+void PhaseTimer::stop() {
+    if (running) {
+        running = false;
+        auto elapsed = chrono::steady_clock::now() - start;
+        metrics.record(phase, chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef PARSER_METRICS_HPP
+#define PARSER_METRICS_HPP
+
+#include <chrono>
+#include "grammar.hpp"
+
+/**
+ * Phase timings and counters of a run
+ */
+class Metrics {
+    vector<pair<string, long long>> phases;
+    vector<pair<string, long long>> counters;
+
+public:
+    /**
+     * Add elapsed time to a phase
+     * @param phase - name of phase
+     * @param nanoseconds - elapsed time
+     */
+    void record(const string &phase, long long nanoseconds);
+
+    /**
+     * Add value to a counter
+     * @param counter - name of counter
+     * @param value - value to be added
+     */
+    void count(const string &counter, long long value);
+
+    /**
+     * Elapsed time of a phase
+     * @param phase - name of phase
+     * @return - nanoseconds, 0 if never recorded
+     */
+    long long elapsed(const string &phase) const;
+
+    /**
+     * Count AST nodes of a tree
+     * @param tree - JSON tree
+     * @return - number of nodes
+     */
+    static long long countNodes(const json &tree);
+
+    /**
+     * Dump metrics as human readable table
+     * @return - table
+     */
+    string table() const;
+
+    /**
+     * Dump metrics as JSON
+     * @return - JSON of phases in nanoseconds and counters
+     */
+    json toJson() const;
+};
+
+/**
+ * Steady clock timer recording into a phase of metrics when stopped or destroyed
+ */
+class PhaseTimer {
+    Metrics &metrics;
+    string phase;
+    chrono::steady_clock::time_point start;
+    bool running;
+
+public:
+    /**
+     * Constructor of class, starts the timer
+     * @param metrics - metrics to record into
+     * @param phase - name of phase
+     */
+    PhaseTimer(Metrics &metrics, string phase);
+
+    /**
+     * Destructor of class, stops the timer
+     */
+    ~PhaseTimer();
+
+    /**
+     * Stop the timer and record elapsed time
+     */
+    void stop();
+};
+
+#endif //PARSER_METRICS_HPP
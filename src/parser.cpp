@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <sstream>
+#include "folding.hpp"
+#include "headers.hpp"
 #include "parser.hpp"
 
 /**
@@ -18,6 +21,7 @@ json Parser::parseParameters() {
     json params = json::array();
     while (declarationIncoming()) {
         Declaration declaration = parseDeclaration("ParameterDeclaration");
+        symbols.declare(declaration.identifier.name, SymbolKind::Variable, declaration.position);
         params.push_back(declaration);
 
         if (lookahead(")")) {
@@ -41,21 +45,13 @@ json Parser::parseBody(bool shouldBeBlock) {
         block.kind = "BlockStatement";
         block.position = lineNumber;
         consume("{");
-        if (!comments.empty()) {
-            for (const json &comment: comments) {
-                statements.push_back(comment);
-            }
-            comments.clear();
-        }
+        symbols.enterScope();
+        flushComments(statements);
         while (curr && curr != '}') {
             statements.push_back(parseStatement());
-            if (!comments.empty()) {
-                for (const json &comment: comments) {
-                    statements.push_back(comment);
-                }
-                comments.clear();
-            }
+            flushComments(statements);
         }
+        symbols.leaveScope();
 
         consume("}");
         block.body = statements;
@@ -64,12 +60,7 @@ json Parser::parseBody(bool shouldBeBlock) {
         BodyStatement line;
         line.kind = "InlineStatement";
         line.position = lineNumber;
-        if (!comments.empty()) {
-            for (const json &comment: comments) {
-                statements.push_back(comment);
-            }
-            comments.clear();
-        }
+        flushComments(statements);
         if (!lookahead(";")) {
             statements.push_back(parseStatement());
         }
@@ -134,6 +125,7 @@ json Parser::parseStatement() {
         statement.kind = "ForStatement";
         statement.position = lineNumber;
         consume("(");
+        symbols.enterScope();
         json init = parseStatement();
         string kind = init["kind"];
         if (kind == "VariableDefinition" || kind == "VariableDeclaration") {
@@ -143,6 +135,7 @@ json Parser::parseStatement() {
         statement.condition = parseExpression(";");
         statement.step = parseExpression(")");
         statement.body = parseBody();
+        symbols.leaveScope();
         return statement;
     } else if (lookahead("return")) { // ReturnStatement
         ReturnStatement statement;
@@ -162,6 +155,8 @@ json Parser::parseStatement() {
         statement.position = lineNumber;
         statement.label = parseExpression(";");
         return statement;
+    } else if (tagDefinitionIncoming()) { // StructDefinition, UnionDefinition, EnumDefinition
+        return parseTagStatement(false);
     } else if (declarationIncoming()) { // Declaration
         return parseDefinition(parseDeclaration());
     } else { // ExpressionStatement
@@ -180,6 +175,37 @@ json Parser::parseStatement() {
  * @return - JSON tree of definition
  */
 json Parser::parseDefinition(const Declaration &declaration, bool isGlobal) {
+    Definition definition = parseDeclarator(declaration, isGlobal);
+    if (curr != ',') {
+        consume(";");
+        return definition;
+    }
+    const json &tag = definition.type.definition;
+    if (tag.is_null() || !tag["identifier"].is_null()) { // multiple identifiers
+        repeatType(definition.type);
+        return definition;
+    }
+    // an anonymous struct, union or enum cannot be named again, so its other identifiers stay in this definition
+    Declaration next;
+    next.type = definition.type;
+    next.type.definition = nullptr;
+    definition.declarators = json::array();
+    while (lookahead(",")) {
+        next.position = lineNumber;
+        next.identifier = parseIdentifier();
+        definition.declarators.push_back(parseDeclarator(next, isGlobal));
+    }
+    consume(";");
+    return definition;
+}
+
+/**
+ * Parse array lengths and initial value of a declared identifier
+ * @param declaration - original declaration
+ * @param isGlobal - is global variable
+ * @return - definition
+ */
+Definition Parser::parseDeclarator(const Declaration &declaration, bool isGlobal) {
     json length;
     bool isArray = false;
     while (lookahead("[")) {
@@ -191,6 +217,7 @@ json Parser::parseDefinition(const Declaration &declaration, bool isGlobal) {
             length.push_back(nullptr);
         }
     }
+    symbols.declare(declaration.identifier.name, SymbolKind::Variable, declaration.position);
     Definition definition;
     definition.identifier = declaration.identifier;
     definition.type = declaration.type;
@@ -207,28 +234,299 @@ json Parser::parseDefinition(const Declaration &declaration, bool isGlobal) {
     if (isGlobal) {
         definition.kind = "Global" + definition.kind;
     }
-    if (curr == ',') { // multiple identifiers
-        json modifiers = definition.type.modifiers;
-        string name;
-        for (const json &modifier: modifiers) {
-            name += string(modifier) + " ";
+    return definition;
+}
+
+/**
+ * Let next declarator of a multiple declaration be parsed as a declaration of the same type
+ * @param type - type of declaration
+ */
+void Parser::repeatType(const Type &type) {
+    json modifiers = type.modifiers;
+    string name;
+    for (const json &modifier: modifiers) {
+        name += string(modifier) + " ";
+    }
+    name += type.name;
+    source.replace(static_cast<unsigned long>(index), 1, name);
+    curr = source[index];
+}
+
+/**
+ * Position after spaces and comments, without lexing them
+ * @param position - start position
+ * @return - position of next token
+ */
+size_t Parser::skipBlanks(size_t position) const {
+    while (position < source.size()) {
+        if (isSpace(source[position])) {
+            position++;
+        } else if (source.compare(position, 2, "//") == 0) {
+            position = min(source.find('\n', position), source.size());
+        } else if (source.compare(position, 2, "/*") == 0) {
+            size_t end = source.find("*/", position + 2);
+            position = end == string::npos ? source.size() : end + 2;
+        } else {
+            break;
         }
-        name += definition.type.name;
-        source.replace(static_cast<unsigned long>(index), 1, name);
+    }
+    return position;
+}
+
+/**
+ * Position after spaces and comments in the buffered part of a stream
+ * @param position - start position
+ * @return - position of next token, npos if a comment or the spaces may go on beyond the buffer
+ */
+size_t Parser::skipBufferedBlanks(size_t position) const {
+    while (position < source.size()) {
+        if (isSpace(source[position])) {
+            position++;
+        } else if (source[position] == '/' && position + 1 == source.size()) {
+            return string::npos;
+        } else if (source.compare(position, 2, "//") == 0) {
+            position = source.find('\n', position);
+        } else if (source.compare(position, 2, "/*") == 0) {
+            size_t end = source.find("*/", position + 2);
+            position = end == string::npos ? end : end + 2;
+        } else {
+            return position;
+        }
+    }
+    return string::npos;
+}
+
+/**
+ * Whether the buffered part of a stream holds a whole top-level item after a position,
+ * with the spaces and comments following it up to the next token
+ * @param position - start position
+ * @return - result
+ */
+bool Parser::isItemBuffered(size_t position) const {
+    position = skipBufferedBlanks(position);
+    if (position == string::npos) {
+        return false;
+    }
+    if (source[position] == '#') { // directive, ending at a newline not escaped by a backslash
+        do {
+            position = source.find('\n', position + 1);
+        } while (position != string::npos && source[position - 1] == '\\');
     } else {
-        consume(";");
+        // an item ends with a semicolon outside brackets, or with the body of a function,
+        // which is the only brace following a closing parenthesis outside brackets
+        int depth = 0;
+        char last = 0;
+        bool isFunction = false;
+        bool isComplete = false;
+        while (!isComplete) {
+            if (position >= source.size()) {
+                return false;
+            }
+            char ch = source[position];
+            if (ch == '"' || ch == '\'') {
+                size_t end = position + 1;
+                while (end < source.size() && source[end] != ch && source[end] != '\n') {
+                    end += source[end] == '\\' ? 2 : 1;
+                }
+                if (end >= source.size()) {
+                    return false;
+                }
+                position = end + 1;
+                last = ch;
+                continue;
+            }
+            if (ch == '/' && (position + 1 == source.size() || source[position + 1] == '/'
+                              || source[position + 1] == '*')) {
+                position = skipBufferedBlanks(position);
+                if (position == string::npos) {
+                    return false;
+                }
+                continue;
+            }
+            if (ch == '(' || ch == '[' || ch == '{') {
+                isFunction = isFunction || (ch == '{' && depth == 0 && last == ')');
+                depth++;
+            } else if (ch == ')' || ch == ']' || ch == '}') {
+                depth--;
+                isComplete = ch == '}' && depth == 0 && isFunction;
+            } else if (ch == ';' && depth == 0) {
+                isComplete = true;
+            }
+            if (!isSpace(ch)) {
+                last = ch;
+            }
+            position++;
+        }
+    }
+    return position != string::npos && skipBufferedBlanks(position) != string::npos;
+}
+
+/**
+ * Determine incoming struct, union or enum definition or forward declaration
+ * @return - whether incoming string is definition
+ */
+bool Parser::tagDefinitionIncoming() const {
+    string_view word = peekWord();
+    if (!isTagKeyword(word)) {
+        return false;
+    }
+    size_t position = skipBlanks(index + word.size());
+    if (position < source.size() && isIdentifierStart(source[position])) {
+        while (position < source.size() && isIdentifierBody(source[position])) {
+            position++;
+        }
+        position = skipBlanks(position);
+        return position < source.size() && (source[position] == '{' || source[position] == ';');
     }
+    return position < source.size() && source[position] == '{';
+}
+
+/**
+ * Parse struct, union or enum definition or forward declaration
+ * @return - JSON tree of definition
+ */
+json Parser::parseTagDefinition() {
+    TagDefinition definition;
+    definition.position = lineNumber;
+    string keyword = parseIdentifier().name;
+    string kind = keyword == "struct" ? "Struct" : keyword == "union" ? "Union" : "Enum";
+    definition.identifier = nullptr;
+    if (isIdentifierStart(curr)) {
+        Identifier identifier = parseIdentifier();
+        symbols.declare(keyword + " " + identifier.name, SymbolKind::Tag, identifier.position);
+        definition.identifier = identifier;
+    }
+    if (curr == ';') { // forward declaration
+        definition.kind = kind + "Declaration";
+        definition.members = nullptr;
+        return definition;
+    }
+    definition.kind = kind + "Definition";
+    consume("{");
+    json members = json::array();
+    flushComments(members);
+    if (keyword == "enum") {
+        while (curr && curr != '}') {
+            EnumMember member;
+            member.kind = "EnumMember";
+            member.position = lineNumber;
+            member.identifier = parseIdentifier();
+            member.value = lookahead("=") ? parseExpression() : json();
+            symbols.declare(member.identifier.name, SymbolKind::Constant, member.position);
+            members.push_back(member);
+            bool hasNext = lookahead(",");
+            flushComments(members);
+            if (!hasNext) {
+                break;
+            }
+        }
+    } else {
+        // member names do not clash with ordinary identifiers
+        symbols.enterScope();
+        while (curr && curr != '}') {
+            members.push_back(parseMember());
+            flushComments(members);
+        }
+        symbols.leaveScope();
+    }
+    consume("}");
+    definition.members = members;
     return definition;
 }
 
+/**
+ * Parse struct, union or enum definition, or variables declared with it
+ * @param isGlobal - is at file scope
+ * @return - JSON tree of definition, declaration or function
+ */
+json Parser::parseTagStatement(bool isGlobal) {
+    Declaration declaration;
+    declaration.position = lineNumber;
+    declaration.type = parseTagType();
+    if (lookahead(";")) {
+        return declaration.type.definition;
+    }
+    // identifiers declared with the type just defined
+    declaration.identifier = parseIdentifier();
+    if (isGlobal && lookahead("(")) {
+        return parseFunction(declaration);
+    }
+    return parseDefinition(declaration, isGlobal);
+}
+
+/**
+ * Parse struct, union or enum type, with definition if given
+ * @return - JSON tree of type
+ */
+Type Parser::parseTagType() {
+    Type type;
+    type.kind = "Type";
+    type.position = lineNumber;
+    type.modifiers = json::array();
+    string keyword(peekWord());
+    if (tagDefinitionIncoming()) {
+        type.definition = parseTagDefinition();
+        const json &tag = type.definition["identifier"];
+        type.name = tag.is_null() ? keyword : keyword + " " + tag["name"].get<string>();
+    } else {
+        lookahead(keyword);
+        type.name = keyword + " " + parseIdentifier().name;
+    }
+    return type;
+}
+
+/**
+ * Parse member of struct or union
+ * @return - JSON tree of member
+ */
+json Parser::parseMember() {
+    Declaration declaration;
+    if (tagDefinitionIncoming()) {
+        declaration.position = lineNumber;
+        declaration.type = parseTagType();
+        if (lookahead(";")) { // nested definition without member name
+            return declaration.type.definition;
+        }
+        declaration.identifier = parseIdentifier();
+    } else {
+        declaration = parseDeclaration();
+    }
+    MemberDeclaration member;
+    member.position = declaration.position;
+    member.type = declaration.type;
+    member.identifier = declaration.identifier;
+    member.kind = "MemberDeclaration";
+    symbols.declare(member.identifier.name, SymbolKind::Variable, member.position);
+    while (lookahead("[")) {
+        member.kind = "ArrayMemberDeclaration";
+        if (!lookahead("]")) {
+            member.length.push_back(parseExpression());
+            consume("]");
+        } else {
+            member.length.push_back(nullptr);
+        }
+    }
+    member.width = lookahead(":") ? parseExpression() : json();
+    if (curr == ',') { // multiple identifiers
+        member.type.definition = nullptr;
+        repeatType(member.type);
+    } else {
+        consume(";");
+    }
+    return member;
+}
+
 /**
  * Parse function
  * @param declaration - original declaration
  * @return - JSON tree of function definition
  */
 json Parser::parseFunction(const Declaration &declaration) {
+    symbols.declare(declaration.identifier.name, SymbolKind::Function, declaration.position);
+    symbols.enterScope();
     json parameters = parseParameters();
     if (lookahead(";")) {
+        symbols.leaveScope();
         FunctionDeclaration functionDeclaration;
         functionDeclaration.identifier = declaration.identifier;
         functionDeclaration.type = declaration.type;
@@ -244,6 +542,7 @@ json Parser::parseFunction(const Declaration &declaration) {
         functionDefinition.kind = "FunctionDefinition";
         functionDefinition.parameters = parameters;
         functionDefinition.body = parseBody(true);
+        symbols.leaveScope();
         return functionDefinition;
     }
 }
@@ -269,8 +568,7 @@ string Parser::scanBinaryOperator() {
     int _index = index;
     for (json &op: operators) {
         if (lookahead(op)) {
-            index = _index;
-            curr = source[index];
+            rewind(_index);
             return op;
         }
     }
@@ -303,6 +601,13 @@ json Parser::parseBinary(json left, int minPrecedence) {
             ahead = scanBinaryOperator();
         }
 
+        if (options.foldConstants) {
+            json folded = ConstantFolder::fold(left, op, right, position, options.decodeNumbers);
+            if (!folded.is_null()) {
+                left = move(folded);
+                continue;
+            }
+        }
         BinaryExpression newExpression;
         newExpression.kind = "BinaryExpression";
         newExpression.position = position;
@@ -337,16 +642,19 @@ json Parser::parseUnary() {
             CallExpression callExpression;
             callExpression.kind = "CallExpression";
             callExpression.position = lineNumber;
-            json arguments;
+            json arguments = json::array();
 
-            while (curr) {
-                arguments.push_back(parseExpression());
+            // an empty argument list stays empty instead of holding a null expression
+            if (!lookahead(")")) {
+                while (curr) {
+                    arguments.push_back(parseExpression());
 
-                if (!lookahead(",")) {
-                    break;
+                    if (!lookahead(",")) {
+                        break;
+                    }
                 }
+                consume(")");
             }
-            consume(")");
             callExpression.arguments = arguments;
             callExpression.callee = literal;
             return callExpression;
@@ -356,6 +664,13 @@ json Parser::parseUnary() {
             parenthesesExpression.position = lineNumber;
             parenthesesExpression.expression = parseExpression();
             consume(")");
+            IntegerConstant constant;
+            const json &expression = parenthesesExpression.expression;
+            // parentheses around a folded constant are dropped, keeping them around a negative one
+            if (options.foldConstants && expression.value("kind", "") != "ParenthesesExpression"
+                && ConstantFolder::decode(expression, constant) && expression["value"].get_ref<const string &>()[0] != '-') {
+                return expression;
+            }
             return parenthesesExpression;
         }
     } else {
@@ -384,18 +699,21 @@ json Parser::parseLiteral() {
         literal.value = entries;
         return literal;
     } else if (curr == '\'') { // CharLiteral
-        next(true, true);
         Literal<string> literal;
         literal.kind = "CharLiteral";
         literal.position = lineNumber;
-        string ch = string(1, curr);
-        if (curr == '\\') {
-            ch = parseEscape();
-        } else {
-            next(true, true);
+        size_t begin = index + 1;
+        if (begin >= source.size()) {
+            throw unexpected("'");
+        }
+        size_t length = source[begin] == '\\' ? escapeLength(source, begin) : 1;
+        if (length == 0) {
+            advance(begin + 1);
+            throw unexpected("escape sequence");
         }
+        literal.value = source.substr(begin, length);
+        advance(begin + length);
         consume("'");
-        literal.value = ch;
         return literal;
     } else if (curr == '"') { // StringLiteral
         Literal<string> literal;
@@ -406,8 +724,12 @@ json Parser::parseLiteral() {
     } else if (lookahead("0x")) { // HexNumberLiteral
         return parseNumber(16);
     } else if (lookahead("-0x")) { // HexNumberLiteral
-        Literal<string> literal = parseNumber(16);
+        NumberLiteral literal = parseNumber(16);
         literal.value = "-" + literal.value;
+        if (literal.decoded.is_number_unsigned()) {
+            uint64_t value = literal.decoded;
+            literal.decoded = value <= static_cast<uint64_t>(INT64_MAX) + 1 ? json(static_cast<int64_t>(0 - value)) : json();
+        }
         return literal;
     } else if (isFloat(curr) || curr == '-') { // NumberLiteral
         return parseNumber(10);
@@ -418,27 +740,28 @@ json Parser::parseLiteral() {
     }
 }
 
+/**
+ * Identifier starting at current position, without moving
+ * @return - identifier, empty if none
+ */
+string_view Parser::peekWord() const {
+    if (!isIdentifierStart(curr)) {
+        return {};
+    }
+    size_t end = index + 1;
+    while (end < source.size() && isIdentifierBody(source[end])) {
+        end++;
+    }
+    return string_view(source).substr(index, end - index);
+}
+
 /**
  * Determine incoming declaration
  * @return - whether incoming string is declaration
  */
 bool Parser::declarationIncoming() {
-    int prevIndex = index;
-    for (json &modifier: typeModifiers) {
-        if (lookahead(modifier)) {
-            index = prevIndex;
-            curr = source[index];
-            return true;
-        }
-    }
-    for (json &name: typeNames) {
-        if (lookahead(name)) {
-            index = prevIndex;
-            curr = source[index];
-            return true;
-        }
-    }
-    return false;
+    string_view word = peekWord();
+    return !word.empty() && (isTypeModifier(word) || isTagKeyword(word) || symbols.isType(word));
 }
 
 /**
@@ -453,27 +776,36 @@ Declaration Parser::parseDeclaration(const string &kind) {
     type.kind = "Type";
     type.position = lineNumber;
     do {
-        hasModifier = false;
-        for (json &modifier: typeModifiers) {
-            if (lookahead(modifier)) {
-                modifiers.push_back(modifier);
-                hasModifier = true;
-            }
+        string word(peekWord());
+        hasModifier = isTypeModifier(word) && lookahead(word);
+        if (hasModifier) {
+            modifiers.push_back(word);
         }
     } while (hasModifier);
-    for (json &name: typeNames) {
-        if (lookahead(name)) {
-            type.modifiers = modifiers;
-            type.name = name;
-            Declaration declaration;
-            declaration.position = lineNumber;
-            declaration.identifier = parseIdentifier();
-            declaration.type = type;
-            if (!kind.empty()) {
-                declaration.kind = kind;
-            }
-            return declaration;
+    string name(peekWord());
+    if (isTagKeyword(name)) { // struct, union or enum type
+        type = parseTagType();
+        type.modifiers = modifiers;
+        Declaration declaration;
+        declaration.position = lineNumber;
+        declaration.identifier = parseIdentifier();
+        declaration.type = type;
+        if (!kind.empty()) {
+            declaration.kind = kind;
+        }
+        return declaration;
+    }
+    if (symbols.isType(name) && lookahead(name)) {
+        type.modifiers = modifiers;
+        type.name = name;
+        Declaration declaration;
+        declaration.position = lineNumber;
+        declaration.identifier = parseIdentifier();
+        declaration.type = type;
+        if (!kind.empty()) {
+            declaration.kind = kind;
         }
+        return declaration;
     }
     if (!modifiers.empty()) {
         type.name = modifiers.back();
@@ -516,7 +848,37 @@ json Parser::parseInclude() {
     str.push_back(curr);
     statement.file = str;
     next(true);
-    return statement;
+    json tree = statement;
+    if (options.followIncludes) {
+        shared_ptr<const Header> header = include(str);
+        if (header) {
+            tree["path"] = header->path;
+            // typedefs of header make its type names usable in the including file
+            for (const string &name: header->typeNames) {
+                if (!symbols.isType(name)) {
+                    symbols.declare(name, SymbolKind::Type, statement.position);
+                }
+            }
+        }
+    }
+    return tree;
+}
+
+/**
+ * Load header of #include statement
+ * @param file - file of #include statement, with quotes or angle brackets
+ * @return - parsed header, nullptr if not found or included recursively
+ */
+shared_ptr<const Header> Parser::include(string_view file) {
+    string path = HeaderCache::resolve(file, options.directory, options.includePaths);
+    if (path.empty()) {
+        return nullptr;
+    }
+    shared_ptr<const Header> header = HeaderCache::shared().load(path, options);
+    if (header && find(headers.begin(), headers.end(), header) == headers.end()) {
+        headers.push_back(header);
+    }
+    return header;
 }
 
 /**
@@ -551,62 +913,28 @@ json Parser::parsePredefine() {
 /**
  * Parse string literal
  * @param keepBlanks - should keep spaces
- * @return - string literal
+ * @return - string literal as written in source, escape sequences are validated but kept
  */
 string Parser::parseString(bool keepBlanks) {
-    string str;
-    next(true, true);
-    while (curr && curr != '"') {
-        if (curr == '\\') {
-            str += parseEscape();
-        } else {
-            str.push_back(curr);
-            next(true, true);
+    size_t begin = index + 1;
+    size_t end = scanString(source, begin);
+    while (source[end] == '\\') {
+        size_t length = escapeLength(source, end);
+        if (length == 0) {
+            advance(end + 1);
+            throw unexpected("escape sequence");
         }
+        end = scanString(source, end + length);
     }
+    string str = source.substr(begin, end - begin);
+    advance(end);
     if (!lookahead("\"", keepBlanks)) {
         throw unexpected("double quote");
     }
+    statistics.tokens++;
     return str;
 }
 
-/**
- * Parse escaped char
- * @return - unescaped char
- */
-string Parser::parseEscape() {
-    index++;
-    curr = source[index];
-    if (curr == 'x') {
-        next(true, true);
-        int code = 0;
-
-        for (int i = 0; i < 2; i++) {
-            if (isHex(curr)) {
-                code = code * 16 + (int) string("0123456789abcdef").find((char) tolower(curr));
-                next(true, true);
-            }
-        }
-        return string(1, code);
-    } else if (isOct(curr)) {
-        int code = 0;
-
-        for (int i = 0; i < 3; i++) {
-            if (isOct(curr)) {
-                code = code * 8 + (int) string("01234567").find((char) tolower(curr));
-                next(true, true);
-            }
-        }
-        return string(1, code);
-    } else if (escapes[curr]) {
-        string escaped = "\\" + string(1, curr);
-        next(true, true);
-        return escaped;
-    } else {
-        throw unexpected("escape sequence");
-    }
-}
-
 /**
  * Parse identifier
  * @param keepBlanks - should keep spaces
@@ -628,6 +956,7 @@ Identifier Parser::parseIdentifier(bool keepBlanks) {
     if (!keepBlanks) {
         skipSpaces();
     }
+    statistics.tokens++;
     identifier.name = name;
     return identifier;
 }
@@ -637,84 +966,116 @@ Identifier Parser::parseIdentifier(bool keepBlanks) {
  * @param digits - valid digits
  * @return - JSON tree of number literal
  */
-Literal<string> Parser::parseNumber(int digits) {
-    if (digits == 16 && !isHex(curr)) {
+NumberLiteral Parser::parseNumber(int digits) {
+    bool isHexadecimal = digits == 16;
+    if (isHexadecimal && !isHex(curr)) {
         throw unexpected("Number");
     }
-    Literal<string> number;
+    NumberLiteral number;
     number.position = lineNumber;
-    string type = "NumberLiteral";
-    if (digits == 16) {
-        type = "HexNumberLiteral";
-    }
-    if (curr == '.') {
-        type = "FloatNumberLiteral";
-    }
-    string value = string(1, curr);
-    next(true);
-    while ((curr && (digits == 16 ? isHex(curr) : isFloat(curr)))
-           || (digits != 16 && tolower(curr) == 'e')
-           || (curr == '-' && digits != 16 && tolower(source[index - 1]) == 'e')) {
-        if (curr == '.') {
-            type = "FloatNumberLiteral";
+    size_t begin = index;
+    size_t end = begin + 1;
+    bool isFloating = curr == '.';
+    while (true) {
+        char ch = source[end];
+        if (isHexadecimal ? isHex(ch) : isFloat(ch)) {
+            isFloating = isFloating || ch == '.';
+        } else if (!isHexadecimal && (tolower(ch) == 'e' || (ch == '-' && tolower(source[end - 1]) == 'e'))) {
+            isFloating = true;
+        } else {
+            break;
         }
-        value.push_back(curr);
-        next(true);
-    }
-    if (value[0] == '0' && type != "FloatNumberLiteral") {
-        type = "OctNumberLiteral";
+        end++;
     }
-    if (tolower(curr) == 'l') {
-        type = "Long" + type;
-        value.push_back(curr);
-        next(true);
-    }
-    if (tolower(curr) == 'u') {
-        type = "Unsigned" + type;
-        value.push_back(curr);
-        next(true);
+    // the base is told by the first digit, after the sign of a negative literal
+    size_t digitsBegin = source[begin] == '-' ? begin + 1 : begin;
+    NumberBase base = isHexadecimal ? NumberBase::Hex
+                                    : isFloating ? NumberBase::Float
+                                                 : source[digitsBegin] == '0' ? NumberBase::Oct : NumberBase::Decimal;
+    size_t digitsEnd = end;
+    int longs = 0;
+    bool isUnsigned = false;
+    // suffixes u, l and ll in either order
+    for (int i = 0; i < 2; i++) {
+        if (!isUnsigned && tolower(source[end]) == 'u') {
+            isUnsigned = true;
+            end++;
+        } else if (!longs && tolower(source[end]) == 'l') {
+            longs = tolower(source[end + 1]) == 'l' ? 2 : 1;
+            end += longs;
+        }
     }
-    if (digits == 16 && curr == '.') {
+    index = static_cast<int>(end - 1);
+    curr = source[index];
+    next(true);
+    if (isHexadecimal && curr == '.') {
         throw unexpected("hex number");
     }
-    if (digits == 16) {
-        value = "0x" + value;
+    number.kind = numberKind(base, isUnsigned, longs);
+    number.value = isHexadecimal ? "0x" + source.substr(begin, end - begin) : source.substr(begin, end - begin);
+    if (options.decodeNumbers) {
+        string_view text(source.data() + begin, digitsEnd - begin);
+        if (base == NumberBase::Float) {
+            double value;
+            if (decodeFloat(text, value)) {
+                number.decoded = value;
+            }
+        } else {
+            bool negative = !text.empty() && text[0] == '-';
+            uint64_t value;
+            if (decodeInteger(negative ? text.substr(1) : text, isHexadecimal ? 16 : base == NumberBase::Oct ? 8 : 10,
+                              value)) {
+                if (!negative) {
+                    number.decoded = value;
+                } else if (value <= static_cast<uint64_t>(INT64_MAX) + 1) {
+                    number.decoded = static_cast<int64_t>(0 - value);
+                }
+            }
+        }
     }
     skipSpaces();
-    number.value = value;
-    number.kind = type;
+    statistics.tokens++;
     return number;
 }
 
 /**
- * Parse comment
- * @return - JSON tree of comment
+ * Record comment starting at current character
+ * @return - whether a comment is skipped
  */
-json Parser::parseComment() {
-    Comment statement;
-    string str;
-    if (lookahead("/*")) {
-        statement.kind = "BlockComment";
-        statement.position = lineNumber;
-        while (curr != '*' || source[index + 1] != '/') {
-            str.push_back(curr);
-            next(true, true);
+bool Parser::scanComment() {
+    if (curr != '/' || (source[index + 1] != '*' && source[index + 1] != '/')) {
+        return false;
+    }
+    CommentSpan span;
+    span.isBlock = source[index + 1] == '*';
+    size_t position = index + 2;
+    // leading spaces are not part of content, an inline comment never continues on next line
+    while (isSpace(source[position]) && !(source[position] == '\n' && !span.isBlock)) {
+        if (source[position] == '\n') {
+            lineNumber++;
         }
-        statement.content = str;
-        index += 2;
-        curr = source[index];
-    } else if (lookahead("//")) {
-        statement.kind = "InlineComment";
-        statement.position = lineNumber;
-        while (curr != '\n') {
-            str.push_back(curr);
-            next(true, true);
+        position++;
+    }
+    span.position = lineNumber;
+    span.begin = position;
+    if (span.isBlock) {
+        size_t end = source.find("*/", position);
+        if (end == string::npos) {
+            index = static_cast<int>(source.size());
+            curr = 0;
+            throw unexpected("*/");
         }
-        statement.content = str;
+        lineNumber += static_cast<int>(count(source.begin() + position, source.begin() + end, '\n'));
+        span.end = end;
+        index = static_cast<int>(end + 2);
     } else {
-        return nullptr;
+        size_t end = source.find('\n', position);
+        span.end = end == string::npos ? source.size() : end;
+        index = static_cast<int>(span.end);
     }
-    return statement;
+    curr = source[index];
+    comments.push_back(span);
+    return true;
 }
 
 /**
@@ -729,6 +1090,7 @@ bool Parser::lookahead(const string &str, bool keepBlanks) {
         if (curr != ch) {
             index = _index;
             curr = source[index];
+            statistics.backtracks++;
             return false;
         }
         next(true);
@@ -737,15 +1099,41 @@ bool Parser::lookahead(const string &str, bool keepBlanks) {
     if (isIdentifierStart(curr) && isIdentifier(str)) {
         index = _index;
         curr = source[index];
+        statistics.backtracks++;
         return false;
     }
 
     if (!keepBlanks) {
         skipSpaces();
     }
+    statistics.tokens++;
     return true;
 }
 
+/**
+ * Move pending comments into statements
+ * @param statements - statements receiving comments
+ */
+void Parser::flushComments(json &statements) {
+    if (options.comments) {
+        for (size_t i = attachedComments; i < comments.size(); i++) {
+            statements.push_back(comment(comments[i]));
+        }
+    }
+    attachedComments = comments.size();
+}
+
+/**
+ * Restore position after looking ahead
+ * @param prevIndex - position to restore
+ */
+void Parser::rewind(int prevIndex) {
+    index = prevIndex;
+    curr = source[index];
+    statistics.tokens--;
+    statistics.backtracks++;
+}
+
 /**
  * Consume rest characters
  * @param str - characters to be skipped
@@ -757,6 +1145,17 @@ void Parser::consume(const string &str) {
         }
         next();
     }
+    statistics.tokens++;
+}
+
+/**
+ * Jump forward to a position without lexing characters in between
+ * @param position - new position
+ */
+void Parser::advance(size_t position) {
+    lineNumber += static_cast<int>(count(source.begin() + index, source.begin() + position, '\n'));
+    index = static_cast<int>(position);
+    curr = source[index];
 }
 
 /**
@@ -793,10 +1192,8 @@ void Parser::next(bool withSpaces, bool withComment) {
             skipped = true;
         }
         if (!withComment) {
-            json comment = parseComment();
-            if (!comment.is_null()) {
+            if (scanComment()) {
                 skipped = true;
-                comments.push_back(comment);
             }
             if (isIllegal(curr)) {
                 throw unexpected("legal character");
@@ -810,45 +1207,28 @@ void Parser::next(bool withSpaces, bool withComment) {
  * @return
  */
 json Parser::parse() {
+    if (options.expandMacros) {
+        if (options.followIncludes) {
+            preprocessor.onInclude([this](string_view file) {
+                shared_ptr<const Header> header = include(file);
+                if (header) {
+                    for (const Macro &macro: header->macros) {
+                        preprocessor.define(macro);
+                    }
+                }
+            });
+        }
+        preprocessor.expand(source, expanded);
+        // the buffers trade places, so a parser being reset keeps the capacity of both
+        source.swap(expanded);
+    }
     next();
     json statements;
     while (curr) {
         skipSpaces();
-        if (!comments.empty()) {
-            for (const json &comment: comments) {
-                statements.push_back(comment);
-            }
-            comments.clear();
-        }
-        if (lookahead("#include")) { // IncludeStatement
-            statements.push_back(parseInclude());
-        } else if (lookahead("#define")) { // PredefineStatement
-            statements.push_back(parsePredefine());
-        } else if (declarationIncoming()) { // GlobalDeclaration
-            Declaration declaration = parseDeclaration();
-            if (lookahead("(")) {
-                statements.push_back(parseFunction(declaration));
-            } else {
-                statements.push_back(parseDefinition(declaration, true));
-            }
-        } else if (lookahead("typedef")) { // TypeDefinition
-            Declaration declaration = parseDeclaration("TypeDefinition");
-            typeNames.push_back(declaration.identifier.name);
-            consume(";");
-            statements.push_back(declaration);
-        } else if (lookahead("struct")) {
-            throw runtime_error("struct is not supported");
-        } else if (lookahead("enum")) {
-            throw runtime_error("enum is not supported");
-        } else {
-            throw unexpected("definition");
-        }
-        if (!comments.empty()) {
-            for (const json &comment: comments) {
-                statements.push_back(comment);
-            }
-            comments.clear();
-        }
+        flushComments(statements);
+        parseItem(statements);
+        flushComments(statements);
         skipSpaces();
     }
 
@@ -856,8 +1236,179 @@ json Parser::parse() {
     return program;
 }
 
+/**
+ * Parse one top-level item
+ * @param statements - statements receiving the item
+ */
+void Parser::parseItem(json &statements) {
+    if (lookahead("#include")) { // IncludeStatement
+        statements.push_back(parseInclude());
+    } else if (lookahead("#define")) { // PredefineStatement
+        statements.push_back(parsePredefine());
+    } else if (tagDefinitionIncoming()) { // StructDefinition, UnionDefinition, EnumDefinition
+        statements.push_back(parseTagStatement(true));
+    } else if (declarationIncoming()) { // GlobalDeclaration
+        Declaration declaration = parseDeclaration();
+        if (lookahead("(")) {
+            statements.push_back(parseFunction(declaration));
+        } else {
+            statements.push_back(parseDefinition(declaration, true));
+        }
+    } else if (lookahead("typedef")) { // TypeDefinition
+        Declaration declaration = parseDeclaration("TypeDefinition");
+        symbols.declare(declaration.identifier.name, SymbolKind::Type, declaration.position);
+        consume(";");
+        statements.push_back(declaration);
+    } else {
+        throw unexpected("definition");
+    }
+}
+
+/**
+ * Parse a program read from a stream in chunks, passing each top-level item to a callback once parsed.
+ * Input is buffered until a whole item can be parsed and released once the item is passed on, so memory
+ * is bounded by the largest item rather than the file. Comments are passed as items if kept,
+ * and commentSpans only holds those of the current item
+ * @param input - input stream
+ * @param onItem - callback receiving each item
+ * @param chunkSize - minimum number of bytes read at once
+ */
+void Parser::parse(istream &input, const function<void(json &item)> &onItem, size_t chunkSize) {
+    if (options.expandMacros) {
+        throw runtime_error("Macros cannot be expanded in a stream");
+    }
+    // reads grow with the buffer, so an item spanning many chunks is scanned a logarithmic number of times
+    auto fill = [&](size_t position) {
+        while (input && !isItemBuffered(position)) {
+            size_t size = source.size();
+            source.resize(size + max(chunkSize, size));
+            input.read(&source[size], static_cast<streamsize>(source.size() - size));
+            source.resize(size + static_cast<size_t>(input.gcount()));
+        }
+    };
+    fill(0);
+    next();
+    while (curr) {
+        json statements;
+        skipSpaces();
+        flushComments(statements);
+        parseItem(statements);
+        flushComments(statements);
+        skipSpaces();
+        for (json &item: statements) {
+            onItem(item);
+        }
+        // attached comments are copied out, the ones lexed after the item go with the next one,
+        // so input up to the first of them or the next token is released once it amounts to a chunk
+        comments.erase(comments.begin(), comments.begin() + static_cast<long>(attachedComments));
+        attachedComments = 0;
+        size_t consumed = comments.empty() ? static_cast<size_t>(index) : comments.front().begin;
+        if (consumed >= chunkSize) {
+            source.erase(0, consumed);
+            index -= static_cast<int>(consumed);
+            for (CommentSpan &span: comments) {
+                span.begin -= consumed;
+                span.end -= consumed;
+            }
+        }
+        fill(static_cast<size_t>(index));
+        curr = source[index];
+    }
+}
+
 /**
  * Constructor of class
  * @param src - source code
+ * @param options - options of parsing
+ * @param memory - memory resource of comment spans, symbol table and macro tables, nullptr for an arena
+ * owned by parser
  */
-Parser::Parser(string src) : source(move(src)), curr(), lineNumber(1), index(-1) {}
+Parser::Parser(string src, ParseOptions options, pmr::memory_resource *memory)
+        : arena(memory ? nullptr : make_unique<ParseArena>()), memory(memory ? memory : &arena->pool),
+          source(move(src)), curr(), index(-1), lineNumber(1), comments(this->memory), attachedComments(0),
+          options(options), symbols(this->memory), preprocessor(options.macroDepth, this->memory) {
+    for (const json &name: typeNames) {
+        symbols.declare(name, SymbolKind::Type, 0);
+    }
+    symbols.seal();
+}
+
+/**
+ * Start over with another source, keeping the source and expansion buffers, the comment spans and the
+ * blocks of symbol and macro tables for reuse
+ * @param src - source code
+ */
+void Parser::reset(string_view src) {
+    source.assign(src.data(), src.size());
+    curr = 0;
+    index = -1;
+    lineNumber = 1;
+    comments.clear();
+    attachedComments = 0;
+    // forget names declared by previous source
+    symbols.clear();
+    statistics = ParserStatistics();
+    preprocessor.reset();
+    headers.clear();
+}
+
+/**
+ * Get counters of parsing
+ * @return - statistics
+ */
+const ParserStatistics &Parser::stats() const {
+    return statistics;
+}
+
+/**
+ * Get all comments of parsed source, whether kept in AST or not
+ * @return - comment spans in source order
+ */
+const pmr::vector<CommentSpan> &Parser::commentSpans() const {
+    return comments;
+}
+
+/**
+ * Get macros defined by parsed source, available when macros are expanded
+ * @return - macros in order of definition
+ */
+vector<Macro> Parser::macros() const {
+    return preprocessor.macros();
+}
+
+/**
+ * Get type names defined by parsed source and its included headers
+ * @return - type names in order of definition
+ */
+vector<string> Parser::typeDefinitions() const {
+    return symbols.types();
+}
+
+/**
+ * Get names declared by parsed source
+ * @return - symbol table
+ */
+const SymbolTable &Parser::symbolTable() const {
+    return symbols;
+}
+
+/**
+ * Get headers included by parsed source, available when includes are followed
+ * @return - headers in order of inclusion
+ */
+const vector<shared_ptr<const Header>> &Parser::includedHeaders() const {
+    return headers;
+}
+
+/**
+ * Build comment node from a span
+ * @param span - comment span
+ * @return - JSON tree of comment
+ */
+json Parser::comment(const CommentSpan &span) const {
+    Comment statement;
+    statement.kind = span.isBlock ? "BlockComment" : "InlineComment";
+    statement.position = span.position;
+    statement.content = source.substr(span.begin, span.end - span.begin);
+    return statement;
+}
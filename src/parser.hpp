@@ -1,7 +1,14 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <functional>
+#include <istream>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
 #include "grammar.hpp"
+#include "preprocessor.hpp"
+#include "symbols.hpp"
 
 struct Program {
     string kind;
@@ -21,9 +28,20 @@ struct Comment : ProgramItem {
     string content;
 };
 
+/**
+ * comment recorded by lexer, its content is only copied when attached to AST
+ */
+struct CommentSpan {
+    bool isBlock;
+    int position;
+    size_t begin;
+    size_t end;
+};
+
 struct Type : ProgramItem {
     json modifiers;
     string name;
+    json definition;
 };
 
 struct Identifier : ProgramItem {
@@ -44,6 +62,22 @@ struct Declaration : ProgramItem {
 struct Definition : Declaration {
     json length;
     json value;
+    json declarators;
+};
+
+struct MemberDeclaration : Declaration {
+    json length;
+    json width;
+};
+
+struct TagDefinition : ProgramItem {
+    json identifier;
+    json members;
+};
+
+struct EnumMember : ProgramItem {
+    Identifier identifier;
+    json value;
 };
 
 struct FunctionDeclaration : Declaration {
@@ -59,6 +93,10 @@ struct Literal : ProgramItem {
     T value;
 };
 
+struct NumberLiteral : Literal<string> {
+    json decoded;
+};
+
 struct IndexExpression : ProgramItem {
     json array;
     json indexes;
@@ -110,14 +148,14 @@ struct ExpressionStatement : ProgramItem {
     json expression;
 };
 
-void to_json(json &j, const Program &p) {
+inline void to_json(json &j, const Program &p) {
     j = json{
             {"kind", p.kind},
             {"body", p.body},
     };
 }
 
-void to_json(json &j, const IncludeStatement &p) {
+inline void to_json(json &j, const IncludeStatement &p) {
     j = json{
             {"kind",     p.kind},
             {"position", p.position},
@@ -125,7 +163,7 @@ void to_json(json &j, const IncludeStatement &p) {
     };
 }
 
-void to_json(json &j, const Comment &p) {
+inline void to_json(json &j, const Comment &p) {
     j = json{
             {"kind",     p.kind},
             {"position", p.position},
@@ -133,16 +171,19 @@ void to_json(json &j, const Comment &p) {
     };
 }
 
-void to_json(json &j, const Type &p) {
+inline void to_json(json &j, const Type &p) {
     j = json{
             {"kind",      p.kind},
             {"position",  p.position},
             {"name",      p.name},
             {"modifiers", p.modifiers},
     };
+    if (!p.definition.is_null()) {
+        j["definition"] = p.definition;
+    }
 }
 
-void to_json(json &j, const Identifier &p) {
+inline void to_json(json &j, const Identifier &p) {
     j = json{
             {"kind",     p.kind},
             {"position", p.position},
@@ -150,7 +191,7 @@ void to_json(json &j, const Identifier &p) {
     };
 }
 
-void to_json(json &j, const Declaration &p) {
+inline void to_json(json &j, const Declaration &p) {
     j = json{
             {"kind",       p.kind},
             {"position",   p.position},
@@ -159,7 +200,7 @@ void to_json(json &j, const Declaration &p) {
     };
 }
 
-void to_json(json &j, const Definition &p) {
+inline void to_json(json &j, const Definition &p) {
     j = json{
             {"kind",       p.kind},
             {"position",   p.position},
@@ -172,9 +213,12 @@ void to_json(json &j, const Definition &p) {
     if (!p.value.is_null()) {
         j["value"] = p.value;
     }
+    if (!p.declarators.is_null()) {
+        j["declarators"] = p.declarators;
+    }
 }
 
-void to_json(json &j, const FunctionDeclaration &p) {
+inline void to_json(json &j, const FunctionDeclaration &p) {
     j = json{
             {"kind",       p.kind},
             {"position",   p.position},
@@ -184,7 +228,7 @@ void to_json(json &j, const FunctionDeclaration &p) {
     };
 }
 
-void to_json(json &j, const FunctionDefinition &p) {
+inline void to_json(json &j, const FunctionDefinition &p) {
     j = json{
             {"kind",       p.kind},
             {"position",   p.position},
@@ -204,7 +248,18 @@ void to_json(json &j, const Literal<T> &p) {
     };
 }
 
-void to_json(json &j, const IndexExpression &p) {
+inline void to_json(json &j, const NumberLiteral &p) {
+    j = json{
+            {"kind",     p.kind},
+            {"position", p.position},
+            {"value",    p.value},
+    };
+    if (!p.decoded.is_null()) {
+        j["decoded"] = p.decoded;
+    }
+}
+
+inline void to_json(json &j, const IndexExpression &p) {
     j = json{
             {"kind",     p.kind},
             {"position", p.position},
@@ -213,7 +268,7 @@ void to_json(json &j, const IndexExpression &p) {
     };
 }
 
-void to_json(json &j, const CallExpression &p) {
+inline void to_json(json &j, const CallExpression &p) {
     j = json{
             {"kind",      p.kind},
             {"position",  p.position},
@@ -222,7 +277,7 @@ void to_json(json &j, const CallExpression &p) {
     };
 }
 
-void to_json(json &j, const ParenthesesExpression &p) {
+inline void to_json(json &j, const ParenthesesExpression &p) {
     j = json{
             {"kind",       p.kind},
             {"position",   p.position},
@@ -230,7 +285,7 @@ void to_json(json &j, const ParenthesesExpression &p) {
     };
 }
 
-void to_json(json &j, const BodyStatement &p) {
+inline void to_json(json &j, const BodyStatement &p) {
     j = json{
             {"kind",     p.kind},
             {"position", p.position},
@@ -238,7 +293,42 @@ void to_json(json &j, const BodyStatement &p) {
     };
 }
 
-void to_json(json &j, const IfStatement &p) {
+inline void to_json(json &j, const MemberDeclaration &p) {
+    j = json{
+            {"kind",       p.kind},
+            {"position",   p.position},
+            {"identifier", p.identifier},
+            {"type",       p.type},
+    };
+    if (!p.length.empty()) {
+        j["length"] = p.length;
+    }
+    if (!p.width.is_null()) {
+        j["width"] = p.width;
+    }
+}
+
+inline void to_json(json &j, const TagDefinition &p) {
+    j = json{
+            {"kind",       p.kind},
+            {"position",   p.position},
+            {"identifier", p.identifier},
+    };
+    if (!p.members.is_null()) {
+        j["members"] = p.members;
+    }
+}
+
+inline void to_json(json &j, const EnumMember &p) {
+    j = json{
+            {"kind",       p.kind},
+            {"position",   p.position},
+            {"identifier", p.identifier},
+            {"value",      p.value},
+    };
+}
+
+inline void to_json(json &j, const IfStatement &p) {
     j = json{
             {"kind",      p.kind},
             {"position",  p.position},
@@ -248,7 +338,7 @@ void to_json(json &j, const IfStatement &p) {
     };
 }
 
-void to_json(json &j, const WhileStatement &p) {
+inline void to_json(json &j, const WhileStatement &p) {
     j = json{
             {"kind",      p.kind},
             {"position",  p.position},
@@ -257,7 +347,7 @@ void to_json(json &j, const WhileStatement &p) {
     };
 }
 
-void to_json(json &j, const ForStatement &p) {
+inline void to_json(json &j, const ForStatement &p) {
     j = json{
             {"kind",      p.kind},
             {"position",  p.position},
@@ -268,7 +358,7 @@ void to_json(json &j, const ForStatement &p) {
     };
 }
 
-void to_json(json &j, const ReturnStatement &p) {
+inline void to_json(json &j, const ReturnStatement &p) {
     j = json{
             {"kind",     p.kind},
             {"position", p.position},
@@ -276,7 +366,7 @@ void to_json(json &j, const ReturnStatement &p) {
     };
 }
 
-void to_json(json &j, const InterruptStatement &p) {
+inline void to_json(json &j, const InterruptStatement &p) {
     j = json{
             {"kind",     p.kind},
             {"position", p.position},
@@ -284,7 +374,7 @@ void to_json(json &j, const InterruptStatement &p) {
     };
 }
 
-void to_json(json &j, const ExpressionStatement &p) {
+inline void to_json(json &j, const ExpressionStatement &p) {
     j = json{
             {"kind",       p.kind},
             {"position",   p.position},
@@ -292,7 +382,7 @@ void to_json(json &j, const ExpressionStatement &p) {
     };
 }
 
-void to_json(json &j, const PredefineStatement &p) {
+inline void to_json(json &j, const PredefineStatement &p) {
     j = json{
             {"kind",       p.kind},
             {"position",   p.position},
@@ -302,7 +392,7 @@ void to_json(json &j, const PredefineStatement &p) {
     };
 }
 
-void to_json(json &j, const BinaryExpression &p) {
+inline void to_json(json &j, const BinaryExpression &p) {
     j = json{
             {"kind",     p.kind},
             {"position", p.position},
@@ -312,15 +402,102 @@ void to_json(json &j, const BinaryExpression &p) {
     };
 }
 
+/**
+ * options of parsing
+ */
+struct ParseOptions {
+    /**
+     * keep comments in AST
+     */
+    bool comments = true;
+
+    /**
+     * store value of number literals as "decoded"
+     */
+    bool decodeNumbers = false;
+
+    /**
+     * fold binary expressions over integer literals into literals
+     */
+    bool foldConstants = false;
+
+    /**
+     * expand #define macros before parsing
+     */
+    bool expandMacros = false;
+
+    /**
+     * maximum depth of nested macro expansion
+     */
+    int macroDepth = 64;
+
+    /**
+     * parse included headers for their typedefs and macros, through the process-wide header cache
+     */
+    bool followIncludes = false;
+
+    /**
+     * directories searched for included headers
+     */
+    vector<string> includePaths;
+
+    /**
+     * directory of source file, searched first for quoted headers
+     */
+    string directory = ".";
+};
+
+struct Header;
+
+/**
+ * counters collected while parsing
+ */
+struct ParserStatistics {
+    long long tokens = 0;
+    long long backtracks = 0;
+};
+
+/**
+ * memory of a parser not given any, a pool recycling blocks freed while parsing over an arena
+ * which returns everything to the heap in one shot when the parser is destroyed
+ */
+struct ParseArena {
+    pmr::monotonic_buffer_resource arena;
+    pmr::unsynchronized_pool_resource pool{&arena};
+};
+
 /**
  * parser class
  */
 class Parser : Grammar {
+    friend struct Benchmark;
+
+    unique_ptr<ParseArena> arena;
+    pmr::memory_resource *memory;
     string source;
+    string expanded;
     char curr;
     int index;
     int lineNumber;
-    json comments;
+    pmr::vector<CommentSpan> comments;
+    size_t attachedComments;
+    ParseOptions options;
+    ParserStatistics statistics;
+    SymbolTable symbols;
+    Preprocessor preprocessor;
+    vector<shared_ptr<const Header>> headers;
+
+    /**
+     * Attach comments lexed since last call to statements if comments are kept
+     * @param statements - statements receiving comments
+     */
+    void flushComments(json &statements);
+
+    /**
+     * Restore position after looking ahead
+     * @param prevIndex - position to restore
+     */
+    void rewind(int prevIndex);
 
     /**
      * Error on unexpected character
@@ -356,6 +533,79 @@ class Parser : Grammar {
      */
     json parseDefinition(const Declaration& declaration, bool isGlobal = false);
 
+    /**
+     * Parse array lengths and initial value of a declared identifier
+     * @param declaration - original declaration
+     * @param isGlobal - is global variable
+     * @return - definition
+     */
+    Definition parseDeclarator(const Declaration &declaration, bool isGlobal);
+
+    /**
+     * Parse struct, union or enum definition, or variables declared with it
+     * @param isGlobal - is at file scope
+     * @return - JSON tree of definition, declaration or function
+     */
+    json parseTagStatement(bool isGlobal);
+
+    /**
+     * Let next declarator of a multiple declaration be parsed as a declaration of the same type
+     * @param type - type of declaration
+     */
+    void repeatType(const Type &type);
+
+    /**
+     * Position after spaces and comments, without lexing them
+     * @param position - start position
+     * @return - position of next token
+     */
+    size_t skipBlanks(size_t position) const;
+
+    /**
+     * Position after spaces and comments in the buffered part of a stream
+     * @param position - start position
+     * @return - position of next token, npos if a comment or the spaces may go on beyond the buffer
+     */
+    size_t skipBufferedBlanks(size_t position) const;
+
+    /**
+     * Whether the buffered part of a stream holds a whole top-level item after a position,
+     * with the spaces and comments following it up to the next token
+     * @param position - start position
+     * @return - result
+     */
+    bool isItemBuffered(size_t position) const;
+
+    /**
+     * Parse one top-level item
+     * @param statements - statements receiving the item
+     */
+    void parseItem(json &statements);
+
+    /**
+     * Determine incoming struct, union or enum definition or forward declaration
+     * @return - whether incoming string is definition
+     */
+    bool tagDefinitionIncoming() const;
+
+    /**
+     * Parse struct, union or enum definition or forward declaration
+     * @return - JSON tree of definition
+     */
+    json parseTagDefinition();
+
+    /**
+     * Parse struct, union or enum type, with definition if given
+     * @return - JSON tree of type
+     */
+    Type parseTagType();
+
+    /**
+     * Parse member of struct or union
+     * @return - JSON tree of member
+     */
+    json parseMember();
+
     /**
      * Parse expression
      * @param end - end character
@@ -389,6 +639,12 @@ class Parser : Grammar {
      */
     json parseLiteral();
 
+    /**
+     * Identifier starting at current position, without moving
+     * @return - identifier, empty if none
+     */
+    string_view peekWord() const;
+
     /**
      * Determine incoming declaration
      * @return - whether incoming string is declaration
@@ -415,6 +671,13 @@ class Parser : Grammar {
      */
     json parseInclude();
 
+    /**
+     * Load header of #include statement
+     * @param file - file of #include statement, with quotes or angle brackets
+     * @return - parsed header, nullptr if not found or included recursively
+     */
+    shared_ptr<const Header> include(string_view file);
+
     /**
      * Parse #define statement
      * @return - JSON tree of #define statement
@@ -424,16 +687,10 @@ class Parser : Grammar {
     /**
      * Parse string literal
      * @param keepBlanks - should keep spaces
-     * @return - string literal
+     * @return - string literal as written in source, escape sequences are validated but kept
      */
     string parseString(bool keepBlanks = false);
 
-    /**
-     * Parse escaped char
-     * @return - unescaped char
-     */
-    string parseEscape();
-
     /**
      * Parse identifier
      * @param keepBlanks - should keep spaces
@@ -446,13 +703,13 @@ class Parser : Grammar {
      * @param digits - valid digits
      * @return - JSON tree of number literal
      */
-    Literal<string> parseNumber(int digits);
+    NumberLiteral parseNumber(int digits);
 
     /**
-     * Parse comment
-     * @return - JSON tree of comment
+     * Record comment starting at current character
+     * @return - whether a comment is skipped
      */
-    json parseComment();
+    bool scanComment();
 
     /**
      * Match string ahead
@@ -468,6 +725,12 @@ class Parser : Grammar {
      */
     void consume(const string& str);
 
+    /**
+     * Jump forward to a position without lexing characters in between
+     * @param position - new position
+     */
+    void advance(size_t position);
+
     /**
      * Skip all spaces
      */
@@ -484,14 +747,78 @@ public:
     /**
      * Constructor of class
      * @param src - source code
+     * @param options - options of parsing
+     * @param memory - memory resource of comment spans, symbol table and macro tables, nullptr for an arena
+     * owned by parser
      */
-    explicit Parser(string src);
+    explicit Parser(string src = "", ParseOptions options = ParseOptions(), pmr::memory_resource *memory = nullptr);
+
+    /**
+     * Start over with another source, keeping the source and expansion buffers, the comment spans and the
+     * blocks of symbol and macro tables for reuse
+     * @param src - source code
+     */
+    void reset(string_view src);
 
     /**
      * Parse source code
      * @return
      */
     json parse();
+
+    /**
+     * Parse a program read from a stream in chunks, passing each top-level item to a callback once parsed.
+     * Input is buffered until a whole item can be parsed and released once the item is passed on, so memory
+     * is bounded by the largest item rather than the file. Comments are passed as items if kept,
+     * and commentSpans only holds those of the current item
+     * @param input - input stream
+     * @param onItem - callback receiving each item
+     * @param chunkSize - minimum number of bytes read at once
+     */
+    void parse(istream &input, const function<void(json &item)> &onItem, size_t chunkSize = 65536);
+
+    /**
+     * Get counters of parsing
+     * @return - statistics
+     */
+    const ParserStatistics &stats() const;
+
+    /**
+     * Get all comments of parsed source, whether kept in AST or not
+     * @return - comment spans in source order
+     */
+    const pmr::vector<CommentSpan> &commentSpans() const;
+
+    /**
+     * Get macros defined by parsed source, available when macros are expanded
+     * @return - macros in order of definition
+     */
+    vector<Macro> macros() const;
+
+    /**
+     * Get type names defined by parsed source and its included headers
+     * @return - type names in order of definition
+     */
+    vector<string> typeDefinitions() const;
+
+    /**
+     * Get names declared by parsed source
+     * @return - symbol table
+     */
+    const SymbolTable &symbolTable() const;
+
+    /**
+     * Get headers included by parsed source, available when includes are followed
+     * @return - headers in order of inclusion
+     */
+    const vector<shared_ptr<const Header>> &includedHeaders() const;
+
+    /**
+     * Build comment node from a span
+     * @param span - comment span
+     * @return - JSON tree of comment
+     */
+    json comment(const CommentSpan &span) const;
 };
 
 
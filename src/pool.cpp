@@ -0,0 +1,124 @@
+#include "pool.hpp"
+
+/**
+ * Constructor of job
+ * @param task - task to be run
+ * @param count - number of tasks
+ */
+ThreadPool::Job::Job(const function<void(size_t, unsigned)> &task, size_t count)
+        : task(task), count(count), cursor(0), running(0) {}
+
+/**
+ * Constructor of class
+ * @param size - number of threads, 0 for hardware concurrency
+ */
+ThreadPool::ThreadPool(unsigned size) : job(nullptr), generation(0), stopping(false) {
+    if (size == 0) {
+        size = thread::hardware_concurrency();
+    }
+    for (unsigned id = 1; id < size; id++) {
+        workers.emplace_back(&ThreadPool::work, this, id);
+    }
+}
+
+/**
+ * Destructor of class
+ */
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread &worker: workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Number of threads taking part in a run, including the caller
+ * @return - number of threads
+ */
+unsigned ThreadPool::size() const {
+    return static_cast<unsigned>(workers.size()) + 1;
+}
+
+/**
+ * Loop of a worker thread
+ * @param id - index of worker
+ */
+void ThreadPool::work(unsigned id) {
+    unsigned long seen = 0;
+    while (true) {
+        Job *current;
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            // the run may already be over when the worker wakes up
+            current = job;
+            if (current == nullptr) {
+                continue;
+            }
+            current->running++;
+        }
+        drain(*current, id);
+        {
+            lock_guard<mutex> guard(lock);
+            current->running--;
+        }
+        done.notify_one();
+    }
+}
+
+/**
+ * Run tasks of a job until all indexes are taken
+ * @param job - job
+ * @param id - index of worker
+ */
+void ThreadPool::drain(Job &job, unsigned id) {
+    for (size_t i = job.cursor++; i < job.count; i = job.cursor++) {
+        try {
+            job.task(i, id);
+        } catch (...) {
+            lock_guard<mutex> guard(lock);
+            if (!job.error) {
+                job.error = current_exception();
+            }
+        }
+    }
+}
+
+/**
+ * Call task(index, worker) for every index in [0, count) and wait for completion
+ * @param count - number of tasks
+ * @param task - task to be run
+ */
+void ThreadPool::run(size_t count, const function<void(size_t, unsigned)> &task) {
+    if (workers.empty() || count < 2) {
+        for (size_t i = 0; i < count; i++) {
+            task(i, 0);
+        }
+        return;
+    }
+    Job current(task, count);
+    {
+        lock_guard<mutex> guard(lock);
+        job = &current;
+        generation++;
+    }
+    wake.notify_all();
+    drain(current, 0);
+    {
+        // every worker that took the job has left it once running drops to 0, later ones find no job
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&] { return current.running == 0; });
+        job = nullptr;
+    }
+    if (current.error) {
+        rethrow_exception(current.error);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef PARSER_POOL_HPP
+#define PARSER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Fixed-size pool of worker threads running indexed tasks
+ */
+class ThreadPool {
+    /**
+     * Tasks of one run. Workers take it under the lock and only touch this run's state,
+     * so a worker late for a run cannot mix with the next one
+     */
+    struct Job {
+        const function<void(size_t, unsigned)> &task;
+        size_t count;
+        atomic<size_t> cursor;
+        unsigned running;
+        exception_ptr error;
+
+        Job(const function<void(size_t, unsigned)> &task, size_t count);
+    };
+
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake;
+    condition_variable done;
+    Job *job;
+    unsigned long generation;
+    bool stopping;
+
+    /**
+     * Loop of a worker thread
+     * @param id - index of worker
+     */
+    void work(unsigned id);
+
+    /**
+     * Run tasks of a job until all indexes are taken
+     * @param job - job
+     * @param id - index of worker
+     */
+    void drain(Job &job, unsigned id);
+
+public:
+    /**
+     * Constructor of class
+     * @param size - number of threads, 0 for hardware concurrency
+     */
+    explicit ThreadPool(unsigned size = 0);
+
+    /**
+     * Destructor of class
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Number of threads taking part in a run, including the caller
+     * @return - number of threads
+     */
+    unsigned size() const;
+
+    /**
+     * Call task(index, worker) for every index in [0, count) and wait for completion
+     * @param count - number of tasks
+     * @param task - task to be run
+     */
+    void run(size_t count, const function<void(size_t, unsigned)> &task);
+};
+
+#endif //PARSER_POOL_HPP
@@ -0,0 +1,450 @@
+#include "preprocessor.hpp"
+
+/**
+ * Constructor of class
+ * @param allocator - allocator of text
+ */
+Macro::Macro(const allocator_type &allocator) : name(allocator), parameters(allocator), body(allocator) {}
+
+/**
+ * Copy constructor of class
+ * @param macro - macro to be copied
+ * @param allocator - allocator of text
+ */
+Macro::Macro(const Macro &macro, const allocator_type &allocator)
+        : name(macro.name, allocator), isFunction(macro.isFunction), parameters(macro.parameters, allocator),
+          body(macro.body, allocator) {}
+
+/**
+ * Move constructor of class
+ * @param macro - macro to be moved
+ * @param allocator - allocator of text
+ */
+Macro::Macro(Macro &&macro, const allocator_type &allocator)
+        : name(move(macro.name), allocator), isFunction(macro.isFunction),
+          parameters(move(macro.parameters), allocator), body(move(macro.body), allocator) {}
+
+/**
+ * Constructor of class
+ * @param maxDepth - maximum depth of nested expansion
+ * @param memory - memory resource of tables
+ */
+Preprocessor::Preprocessor(int maxDepth, pmr::memory_resource *memory)
+        : memory(memory), definitions(memory), table(memory), memo(memory), active(memory), maxDepth(maxDepth) {}
+
+/**
+ * Forget all macros
+ */
+void Preprocessor::reset() {
+    table.clear();
+    definitions.clear();
+    memo.clear();
+    active.clear();
+}
+
+/**
+ * Define a macro
+ * @param macro - macro to be defined
+ */
+void Preprocessor::define(const Macro &macro) {
+    definitions.push_back(macro);
+    const pmr::string &name = definitions.back().name;
+    auto found = table.find(name);
+    if (found != table.end()) {
+        found->second = definitions.size() - 1;
+    } else {
+        table.emplace(name, definitions.size() - 1);
+    }
+    memo.clear();
+}
+
+/**
+ * Remove definition of macro
+ * @param name - name of macro
+ */
+void Preprocessor::undefine(string_view name) {
+    table.erase(name);
+    memo.clear();
+}
+
+/**
+ * Set handler of #include directives, which may define macros of included file
+ * @param handler - handler receiving file with quotes or angle brackets
+ */
+void Preprocessor::onInclude(function<void(string_view)> handler) {
+    includeHandler = move(handler);
+}
+
+/**
+ * Get defined macros
+ * @return - macros in order of definition, removed ones excluded
+ */
+vector<Macro> Preprocessor::macros() const {
+    vector<size_t> indexes;
+    for (const auto &entry: table) {
+        indexes.push_back(entry.second);
+    }
+    sort(indexes.begin(), indexes.end());
+    vector<Macro> list;
+    for (size_t index: indexes) {
+        list.push_back(definitions[index]);
+    }
+    return list;
+}
+
+/**
+ * Length of string or char literal
+ * @param text - text containing literal
+ * @param begin - position of opening quote
+ * @return - length including quotes
+ */
+size_t Preprocessor::literalLength(string_view text, size_t begin) {
+    char quote = text[begin];
+    size_t i = begin + 1;
+    while (i < text.size() && text[i] != quote && text[i] != '\n') {
+        i += text[i] == '\\' ? 2 : 1;
+    }
+    return min(i + 1, text.size()) - begin;
+}
+
+/**
+ * Length of comment
+ * @param text - text containing comment
+ * @param begin - position of slash
+ * @return - length of comment, 0 if no comment starts at begin
+ */
+size_t Preprocessor::commentLength(string_view text, size_t begin) {
+    if (begin + 1 >= text.size()) {
+        return 0;
+    }
+    if (text[begin + 1] == '/') {
+        size_t end = text.find('\n', begin);
+        return (end == string_view::npos ? text.size() : end) - begin;
+    }
+    if (text[begin + 1] == '*') {
+        size_t end = text.find("*/", begin + 2);
+        return (end == string_view::npos ? text.size() : end + 2) - begin;
+    }
+    return 0;
+}
+
+/**
+ * Length of identifier
+ * @param text - text containing identifier
+ * @param begin - position of first character
+ * @return - length of identifier
+ */
+size_t Preprocessor::identifierLength(string_view text, size_t begin) {
+    size_t i = begin + 1;
+    while (i < text.size() && isIdentifierBody(text[i])) {
+        i++;
+    }
+    return i - begin;
+}
+
+/**
+ * Record a #define, #undef or #include directive
+ * @param line - directive without leading #, continuation lines joined
+ */
+void Preprocessor::directive(string_view line) {
+    size_t i = 0;
+    while (i < line.size() && isSpace(line[i])) {
+        i++;
+    }
+    if (i >= line.size() || !isIdentifierStart(line[i])) {
+        return;
+    }
+    size_t length = identifierLength(line, i);
+    string_view word = line.substr(i, length);
+    i += length;
+    while (i < line.size() && isSpace(line[i])) {
+        i++;
+    }
+    if (word == "include") {
+        size_t end = line.find_first_of(line[i] == '<' ? ">" : "\"", i + 1);
+        if (includeHandler && i < line.size() && end != string_view::npos) {
+            includeHandler(line.substr(i, end + 1 - i));
+        }
+        return;
+    }
+    if (i >= line.size() || !isIdentifierStart(line[i])) {
+        return;
+    }
+    length = identifierLength(line, i);
+    Macro macro(memory);
+    macro.name = line.substr(i, length);
+    if (word == "undef") {
+        undefine(macro.name);
+        return;
+    } else if (word != "define") {
+        return;
+    }
+    i += length;
+    macro.isFunction = i < line.size() && line[i] == '(';
+    if (macro.isFunction) {
+        i++;
+        while (i < line.size() && line[i] != ')') {
+            if (isIdentifierStart(line[i])) {
+                length = identifierLength(line, i);
+                macro.parameters.emplace_back(line.substr(i, length));
+                i += length;
+            } else if (line.substr(i, 3) == "...") {
+                macro.parameters.emplace_back("__VA_ARGS__");
+                i += 3;
+            } else {
+                i++;
+            }
+        }
+        i++;
+    }
+    // body without comments, which must not swallow code following a use
+    for (; i < line.size(); i++) {
+        if (line[i] == '"' || line[i] == '\'') {
+            length = literalLength(line, i);
+            macro.body.append(line.substr(i, length));
+            i += length - 1;
+        } else if (line[i] == '/' && (length = commentLength(line, i))) {
+            macro.body.push_back(' ');
+            i += length - 1;
+        } else {
+            macro.body.push_back(line[i]);
+        }
+    }
+    size_t first = macro.body.find_first_not_of(" \t\f\v\r\n");
+    size_t last = macro.body.find_last_not_of(" \t\f\v\r\n");
+    // trimmed in place, as substr would copy through the default resource
+    macro.body.erase(first == string::npos ? 0 : last + 1);
+    macro.body.erase(0, first == string::npos ? 0 : first);
+    define(macro);
+}
+
+/**
+ * Find macro which may be expanded
+ * @param name - identifier
+ * @return - index of macro, definitions size if not defined or being expanded
+ */
+size_t Preprocessor::find(string_view name) const {
+    auto found = table.find(name);
+    if (found == table.end() || std::find(active.begin(), active.end(), found->second) != active.end()) {
+        return definitions.size();
+    }
+    return found->second;
+}
+
+/**
+ * Collect arguments of function-like macro use
+ * @param text - text containing use
+ * @param position - position after macro name, moved after closing parenthesis on success
+ * @param arguments - collected arguments
+ * @return - whether an argument list follows
+ */
+bool Preprocessor::collectArguments(string_view text, size_t &position, pmr::vector<string_view> &arguments) {
+    size_t i = position;
+    while (i < text.size() && isSpace(text[i])) {
+        i++;
+    }
+    if (i >= text.size() || text[i] != '(') {
+        return false;
+    }
+    size_t start = ++i;
+    int level = 0;
+    while (i < text.size()) {
+        char ch = text[i];
+        size_t length;
+        if (ch == '"' || ch == '\'') {
+            i += literalLength(text, i);
+            continue;
+        } else if (ch == '/' && (length = commentLength(text, i))) {
+            i += length;
+            continue;
+        } else if (ch == '(') {
+            level++;
+        } else if (ch == ')' && level > 0) {
+            level--;
+        } else if (ch == ')' || (ch == ',' && level == 0)) {
+            arguments.push_back(text.substr(start, i - start));
+            start = i + 1;
+            if (ch == ')') {
+                position = i + 1;
+                return true;
+            }
+        }
+        i++;
+    }
+    arguments.clear();
+    return false;
+}
+
+/**
+ * Expand one use of macro
+ * @param index - index of macro to be expanded
+ * @param arguments - arguments of function-like macro
+ * @param result - string receiving expansion
+ * @param depth - depth of nested expansion
+ */
+void Preprocessor::expandMacro(size_t index, const pmr::vector<string_view> &arguments, string &result, int depth) {
+    const Macro &macro = definitions[index];
+    if (depth >= maxDepth) {
+        throw runtime_error("Macro " + string(macro.name) + " expands deeper than " + to_string(maxDepth) + " levels");
+    }
+    // expansions of a top-level use do not depend on enclosing expansions, so they can be reused
+    pmr::string key(memory);
+    if (depth == 0) {
+        key = macro.name;
+        for (string_view argument: arguments) {
+            key.push_back('\0');
+            key.append(argument);
+        }
+        auto found = memo.find(key);
+        if (found != memo.end()) {
+            result += found->second;
+            return;
+        }
+    }
+    string replaced;
+    if (macro.isFunction) {
+        bool isVariadic = !macro.parameters.empty() && macro.parameters.back() == "__VA_ARGS__";
+        size_t expected = macro.parameters.size();
+        bool matches = arguments.size() == expected
+                       || (expected == 0 && arguments.size() == 1 && arguments[0].find_first_not_of(" \t\r\n") == string_view::npos)
+                       || (isVariadic && arguments.size() >= expected - 1);
+        if (!matches) {
+            throw runtime_error("Macro " + string(macro.name) + " expects " + to_string(expected) + " arguments");
+        }
+        // arguments are fully expanded before substitution
+        vector<string> values(expected);
+        for (size_t i = 0; i < arguments.size() && expected; i++) {
+            size_t parameter = min(i, expected - 1);
+            if (i > parameter) {
+                values[parameter] += ",";
+            }
+            expandText(arguments[i], values[parameter], depth + 1);
+        }
+        for (string &value: values) {
+            size_t first = value.find_first_not_of(" \t\r\n");
+            size_t last = value.find_last_not_of(" \t\r\n");
+            value = first == string::npos ? "" : value.substr(first, last - first + 1);
+        }
+        string_view body = macro.body;
+        for (size_t i = 0; i < body.size();) {
+            if (body[i] == '"' || body[i] == '\'') {
+                size_t length = literalLength(body, i);
+                replaced.append(body.substr(i, length));
+                i += length;
+            } else if (isIdentifierStart(body[i])) {
+                size_t length = identifierLength(body, i);
+                string_view name = body.substr(i, length);
+                auto parameter = std::find(macro.parameters.begin(), macro.parameters.end(), name);
+                if (parameter != macro.parameters.end()) {
+                    replaced += values[parameter - macro.parameters.begin()];
+                } else {
+                    replaced.append(name);
+                }
+                i += length;
+            } else {
+                replaced.push_back(body[i++]);
+            }
+        }
+    } else {
+        replaced = macro.body;
+    }
+    size_t mark = result.size();
+    active.push_back(index);
+    expandText(replaced, result, depth + 1);
+    active.pop_back();
+    if (depth == 0) {
+        if (memo.size() >= (1u << 16)) {
+            memo.clear();
+        }
+        memo.try_emplace(move(key), string_view(result).substr(mark));
+    }
+}
+
+/**
+ * Expand macros in text
+ * @param text - text to be expanded
+ * @param result - string receiving expansion
+ * @param depth - depth of nested expansion, 0 for source code with directives
+ */
+void Preprocessor::expandText(string_view text, string &result, int depth) {
+    bool lineStart = true;
+    size_t i = 0;
+    while (i < text.size()) {
+        char ch = text[i];
+        size_t length;
+        if (ch == '\n') {
+            result.push_back(depth ? ' ' : ch);
+            lineStart = true;
+            i++;
+            continue;
+        } else if (isSpace(ch)) {
+            result.push_back(ch);
+            i++;
+            continue;
+        }
+        if (ch == '#' && lineStart && depth == 0) { // directive, continued by backslash-newline
+            size_t end = i;
+            string line;
+            while (true) {
+                size_t newline = text.find('\n', end);
+                size_t stop = newline == string_view::npos ? text.size() : newline;
+                if (newline != string_view::npos && stop > end && text[stop - 1] == '\\') {
+                    line.append(text.substr(end, stop - 1 - end));
+                    end = stop + 1;
+                } else {
+                    line.append(text.substr(end, stop - end));
+                    end = stop;
+                    break;
+                }
+            }
+            directive(string_view(line).substr(1));
+            result.append(text.substr(i, end - i));
+            i = end;
+            continue;
+        }
+        lineStart = false;
+        if (ch == '"' || ch == '\'') {
+            length = literalLength(text, i);
+        } else if (ch == '/' && (length = commentLength(text, i))) {
+        } else if (isNumber(ch) || (ch == '.' && i + 1 < text.size() && isNumber(text[i + 1]))) { // number
+            length = 1;
+            while (i + length < text.size() && (isIdentifierBody(text[i + length]) || text[i + length] == '.')) {
+                length++;
+            }
+        } else if (isIdentifierStart(ch)) {
+            length = identifierLength(text, i);
+            size_t index = table.empty() ? definitions.size() : find(text.substr(i, length));
+            if (index < definitions.size()) {
+                size_t position = i + length;
+                pmr::vector<string_view> arguments(memory);
+                if (!definitions[index].isFunction || collectArguments(text, position, arguments)) {
+                    size_t mark = result.size();
+                    expandMacro(index, arguments, result, depth);
+                    if (depth == 0) {
+                        // keep following code on its original line
+                        replace(result.begin() + mark, result.end(), '\n', ' ');
+                        result.append(count(text.begin() + i, text.begin() + position, '\n'), '\n');
+                    }
+                    i = position;
+                    continue;
+                }
+            }
+        } else {
+            length = 1;
+        }
+        result.append(text.substr(i, length));
+        i += length;
+    }
+}
+
+/**
+ * Expand macros used in source, directives are kept as they are and line numbers are preserved
+ * @param source - source code
+ * @param result - string receiving expanded source code, replacing its content but keeping its capacity
+ */
+void Preprocessor::expand(string_view source, string &result) {
+    result.clear();
+    result.reserve(source.size() + source.size() / 8);
+    active.clear();
+    expandText(source, result, 0);
+}
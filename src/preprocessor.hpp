@@ -0,0 +1,173 @@
+#ifndef PARSER_PREPROCESSOR_HPP
+#define PARSER_PREPROCESSOR_HPP
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "grammar.hpp"
+
+/**
+ * macro defined by #define, allocating its text from the memory resource of the containing table
+ */
+struct Macro {
+    using allocator_type = pmr::polymorphic_allocator<char>;
+
+    pmr::string name;
+    bool isFunction = false;
+    pmr::vector<pmr::string> parameters;
+    pmr::string body;
+
+    /**
+     * Constructor of class
+     * @param allocator - allocator of text
+     */
+    explicit Macro(const allocator_type &allocator = {});
+
+    /**
+     * Copy constructor of class
+     * @param macro - macro to be copied
+     * @param allocator - allocator of text
+     */
+    Macro(const Macro &macro, const allocator_type &allocator = {});
+
+    /**
+     * Move constructor of class
+     * @param macro - macro to be moved
+     * @param allocator - allocator of text
+     */
+    Macro(Macro &&macro, const allocator_type &allocator);
+
+    Macro(Macro &&macro) = default;
+
+    Macro &operator=(const Macro &macro) = default;
+
+    Macro &operator=(Macro &&macro) = default;
+};
+
+/**
+ * Expander of #define macros, substituting macro uses while scanning source once.
+ * Tables and argument lists allocate from one memory resource
+ */
+class Preprocessor : Grammar {
+    pmr::memory_resource *memory;
+    pmr::deque<Macro> definitions;
+    pmr::unordered_map<string_view, size_t> table;
+    pmr::unordered_map<pmr::string, pmr::string> memo;
+    pmr::vector<size_t> active;
+    int maxDepth;
+    function<void(string_view)> includeHandler;
+
+    /**
+     * Length of string or char literal
+     * @param text - text containing literal
+     * @param begin - position of opening quote
+     * @return - length including quotes
+     */
+    static size_t literalLength(string_view text, size_t begin);
+
+    /**
+     * Length of comment
+     * @param text - text containing comment
+     * @param begin - position of slash
+     * @return - length of comment, 0 if no comment starts at begin
+     */
+    static size_t commentLength(string_view text, size_t begin);
+
+    /**
+     * Length of identifier
+     * @param text - text containing identifier
+     * @param begin - position of first character
+     * @return - length of identifier
+     */
+    static size_t identifierLength(string_view text, size_t begin);
+
+    /**
+     * Record a #define, #undef or #include directive
+     * @param line - directive without leading #, continuation lines joined
+     */
+    void directive(string_view line);
+
+    /**
+     * Find macro which may be expanded
+     * @param name - identifier
+     * @return - index of macro, definitions size if not defined or being expanded
+     */
+    size_t find(string_view name) const;
+
+    /**
+     * Collect arguments of function-like macro use
+     * @param text - text containing use
+     * @param position - position after macro name, moved after closing parenthesis on success
+     * @param arguments - collected arguments
+     * @return - whether an argument list follows
+     */
+    static bool collectArguments(string_view text, size_t &position, pmr::vector<string_view> &arguments);
+
+    /**
+     * Expand macros in text
+     * @param text - text to be expanded
+     * @param result - string receiving expansion
+     * @param depth - depth of nested expansion, 0 for source code with directives
+     */
+    void expandText(string_view text, string &result, int depth);
+
+    /**
+     * Expand one use of macro
+     * @param index - index of macro to be expanded
+     * @param arguments - arguments of function-like macro
+     * @param result - string receiving expansion
+     * @param depth - depth of nested expansion
+     */
+    void expandMacro(size_t index, const pmr::vector<string_view> &arguments, string &result, int depth);
+
+public:
+    /**
+     * Constructor of class
+     * @param maxDepth - maximum depth of nested expansion
+     * @param memory - memory resource of tables
+     */
+    explicit Preprocessor(int maxDepth = 64, pmr::memory_resource *memory = pmr::get_default_resource());
+
+    /**
+     * Forget all macros
+     */
+    void reset();
+
+    /**
+     * Define a macro
+     * @param macro - macro to be defined
+     */
+    void define(const Macro &macro);
+
+    /**
+     * Remove definition of macro
+     * @param name - name of macro
+     */
+    void undefine(string_view name);
+
+    /**
+     * Set handler of #include directives, which may define macros of included file
+     * @param handler - handler receiving file with quotes or angle brackets
+     */
+    void onInclude(function<void(string_view)> handler);
+
+    /**
+     * Get defined macros
+     * @return - macros in order of definition, removed ones excluded
+     */
+    vector<Macro> macros() const;
+
+    /**
+     * Expand macros used in source, directives are kept as they are and line numbers are preserved
+     * @param source - source code
+     * @param result - string receiving expanded source code, replacing its content but keeping its capacity
+     */
+    void expand(string_view source, string &result);
+};
+
+#endif //PARSER_PREPROCESSOR_HPP
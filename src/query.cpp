@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <stdexcept>
+#include "query.hpp"
+
+/**
+ * Constructor of class
+ * @param root - JSON tree of program
+ */
+AstIndex::AstIndex(const json &root) {
+    add(root, none, 0);
+}
+
+/**
+ * Add a subtree
+ * @param value - JSON tree
+ * @param parent - index of parent node
+ * @param depth - depth of node
+ */
+void AstIndex::add(const json &value, uint32_t parent, uint32_t depth) {
+    if (value.is_array()) {
+        for (const json &item: value) {
+            add(item, parent, depth);
+        }
+        return;
+    }
+    if (!value.is_object()) {
+        return;
+    }
+    auto kindField = value.find("kind");
+    if (kindField == value.end() || !kindField->is_string()) {
+        return;
+    }
+    const string &kind = kindField->get_ref<const string &>();
+    auto found = kindIds.find(kind);
+    if (found == kindIds.end()) {
+        found = kindIds.emplace(kind, static_cast<uint32_t>(kindNames.size())).first;
+        kindNames.push_back(kind);
+        byKind.emplace_back();
+    }
+    auto index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({&value, parent, 0, found->second, depth, kindBit(found->second)});
+    byKind[found->second].push_back(index);
+    for (const auto &item: value.items()) {
+        if (item.value().is_structured()) {
+            add(item.value(), index, depth + 1);
+        }
+    }
+    nodes[index].end = static_cast<uint32_t>(nodes.size());
+    if (parent != none) {
+        nodes[parent].kinds |= nodes[index].kinds;
+    }
+}
+
+/**
+ * Number of nodes
+ * @return - number of nodes
+ */
+size_t AstIndex::size() const {
+    return nodes.size();
+}
+
+/**
+ * Node by index
+ * @param index - index of node in preorder
+ * @return - node
+ */
+const AstNode &AstIndex::node(uint32_t index) const {
+    return nodes[index];
+}
+
+/**
+ * Bit of a kind id in set of kinds, kinds beyond 63 share the last bit
+ * @param kind - id of kind
+ * @return - bit
+ */
+uint64_t AstIndex::kindBit(uint32_t kind) {
+    return uint64_t(1) << min(kind, uint32_t(63));
+}
+
+/**
+ * Id of a kind
+ * @param kind - kind of node
+ * @return - id, unknown if no node has the kind
+ */
+uint32_t AstIndex::kindId(const string &kind) const {
+    auto found = kindIds.find(kind);
+    return found == kindIds.end() ? unknown : found->second;
+}
+
+/**
+ * Name of a kind id
+ * @param id - id of kind
+ * @return - kind of node
+ */
+const string &AstIndex::kindName(uint32_t id) const {
+    return kindNames[id];
+}
+
+/**
+ * Number of distinct kinds
+ * @return - number of kinds
+ */
+size_t AstIndex::kinds() const {
+    return kindNames.size();
+}
+
+/**
+ * Nodes of a kind
+ * @param kind - kind of node
+ * @return - indexes of nodes in preorder
+ */
+const vector<uint32_t> &AstIndex::ofKind(const string &kind) const {
+    static const vector<uint32_t> empty;
+    uint32_t id = kindId(kind);
+    return id == unknown ? empty : byKind[id];
+}
+
+/**
+ * Whether a node is inside the subtree of another
+ * @param ancestor - index of ancestor
+ * @param node - index of node
+ * @return - result
+ */
+bool AstIndex::contains(uint32_t ancestor, uint32_t node) const {
+    return ancestor < node && node < nodes[ancestor].end;
+}
+
+/**
+ * Parse a selector
+ * @param selector - selector text
+ * @return - steps from outermost to innermost
+ */
+vector<AstIndex::Step> AstIndex::parse(string_view selector) const {
+    vector<Step> steps;
+    size_t i = 0;
+    bool isChild = false;
+    auto skipSpaces = [&]() {
+        while (i < selector.size() && selector[i] == ' ') {
+            i++;
+        }
+    };
+    while (true) {
+        skipSpaces();
+        if (i >= selector.size()) {
+            break;
+        }
+        if (selector[i] == '>') {
+            if (steps.empty() || isChild) {
+                throw runtime_error("Selector: unexpected >");
+            }
+            isChild = true;
+            i++;
+            continue;
+        }
+        Step step;
+        step.isChild = isChild;
+        isChild = false;
+        size_t start = i;
+        while (i < selector.size() && selector[i] != ' ' && selector[i] != '>' && selector[i] != '[') {
+            i++;
+        }
+        string kind(selector.substr(start, i - start));
+        if (kind.empty()) {
+            throw runtime_error("Selector: expect kind at " + to_string(start));
+        }
+        step.kind = kind == "*" ? anyKind : kindId(kind);
+        while (i < selector.size() && selector[i] == '[') {
+            Predicate predicate;
+            predicate.negated = false;
+            predicate.hasValue = false;
+            size_t close = selector.find(']', i);
+            if (close == string_view::npos) {
+                throw runtime_error("Selector: expect ]");
+            }
+            string_view body = selector.substr(i + 1, close - i - 1);
+            size_t equal = body.find('=');
+            string_view path = body.substr(0, equal);
+            if (equal != string_view::npos) {
+                predicate.hasValue = true;
+                if (equal > 0 && body[equal - 1] == '!') {
+                    predicate.negated = true;
+                    path = body.substr(0, equal - 1);
+                }
+                string_view value = body.substr(equal + 1);
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                    value = value.substr(1, value.size() - 2);
+                }
+                predicate.value = string(value);
+            }
+            for (size_t begin = 0; begin <= path.size();) {
+                size_t dot = min(path.find('.', begin), path.size());
+                predicate.path.emplace_back(path.substr(begin, dot - begin));
+                begin = dot + 1;
+            }
+            step.predicates.push_back(move(predicate));
+            i = close + 1;
+        }
+        steps.push_back(move(step));
+    }
+    if (steps.empty() || isChild) {
+        throw runtime_error("Selector: expect kind");
+    }
+    return steps;
+}
+
+/**
+ * Whether a node satisfies one step, without checking its ancestors
+ * @param node - index of node
+ * @param step - step
+ * @return - result
+ */
+bool AstIndex::matches(uint32_t node, const Step &step) const {
+    if (step.kind != anyKind && nodes[node].kind != step.kind) {
+        return false;
+    }
+    for (const Predicate &predicate: step.predicates) {
+        const json *value = nodes[node].value;
+        for (const string &field: predicate.path) {
+            auto found = value->is_object() ? value->find(field) : value->end();
+            if (!value->is_object() || found == value->end()) {
+                value = nullptr;
+                break;
+            }
+            value = &*found;
+        }
+        bool isPresent = value && !value->is_null();
+        if (!predicate.hasValue) {
+            if (!isPresent) {
+                return false;
+            }
+            continue;
+        }
+        bool isEqual = false;
+        if (isPresent) {
+            // a node such as an identifier is compared by its name
+            if (value->is_object() && value->find("name") != value->end()) {
+                value = &(*value)["name"];
+            }
+            isEqual = value->is_string() ? value->get_ref<const string &>() == predicate.value
+                                         : value->dump() == predicate.value;
+        }
+        if (isEqual == predicate.negated) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Whether ancestors of a node matching a step satisfy the steps before it
+ * @param node - index of node
+ * @param steps - steps of selector
+ * @param step - index of step matched by node
+ * @return - result
+ */
+bool AstIndex::matchesAncestors(uint32_t node, const vector<Step> &steps, size_t step) const {
+    if (step == 0) {
+        return true;
+    }
+    for (uint32_t ancestor = nodes[node].parent; ancestor != none; ancestor = nodes[ancestor].parent) {
+        if (matches(ancestor, steps[step - 1]) && matchesAncestors(ancestor, steps, step - 1)) {
+            return true;
+        }
+        if (steps[step].isChild) {
+            break;
+        }
+    }
+    return false;
+}
+
+/**
+ * Find nodes matching a selector.
+ * A selector is a list of kinds, "*" for any kind, separated by " " for descendants or ">" for children.
+ * Each kind may be followed by conditions on fields, [field], [field=value] or [field!=value], where a field is
+ * a path like callee.name and a node compared with a value is compared by its name,
+ * e.g. ForStatement CallExpression[callee=malloc]
+ * @param selector - selector text
+ * @return - indexes of matching nodes in preorder
+ */
+vector<uint32_t> AstIndex::select(string_view selector) const {
+    vector<Step> steps = parse(selector);
+    for (const Step &step: steps) {
+        if (step.kind == unknown) {
+            return {};
+        }
+    }
+    vector<uint32_t> result;
+    const Step &last = steps.back();
+    auto check = [&](uint32_t node) {
+        if (matches(node, last) && matchesAncestors(node, steps, steps.size() - 1)) {
+            result.push_back(node);
+        }
+    };
+    // candidates come from the kind list of the innermost step, so other nodes are never visited
+    if (last.kind == anyKind) {
+        for (uint32_t node = 0; node < nodes.size(); node++) {
+            check(node);
+        }
+    } else {
+        for (uint32_t node: byKind[last.kind]) {
+            check(node);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,175 @@
+#ifndef PARSER_QUERY_HPP
+#define PARSER_QUERY_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include "../lib/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * node of AST in preorder, its subtree being the nodes in (index, end)
+ * and kinds being the set of kind bits of the node and its subtree
+ */
+struct AstNode {
+    const json *value;
+    uint32_t parent;
+    uint32_t end;
+    uint32_t kind;
+    uint32_t depth;
+    uint64_t kinds;
+};
+
+/**
+ * Index of an AST built in one walk: nodes in preorder with parent links and a list of nodes per kind.
+ * Nodes point into the indexed tree, which must outlive the index and not be modified
+ */
+class AstIndex {
+    /**
+     * condition on a field, e.g. [callee=malloc]
+     */
+    struct Predicate {
+        vector<string> path;
+        bool negated;
+        bool hasValue;
+        string value;
+    };
+
+    /**
+     * step of a selector, e.g. CallExpression[callee=malloc]
+     */
+    struct Step {
+        uint32_t kind;
+        bool isChild;
+        vector<Predicate> predicates;
+    };
+
+    /**
+     * kind id of "*" in selector
+     */
+    static constexpr uint32_t anyKind = UINT32_MAX - 1;
+
+    vector<AstNode> nodes;
+    vector<string> kindNames;
+    unordered_map<string, uint32_t> kindIds;
+    vector<vector<uint32_t>> byKind;
+
+    /**
+     * Add a subtree
+     * @param value - JSON tree
+     * @param parent - index of parent node
+     * @param depth - depth of node
+     */
+    void add(const json &value, uint32_t parent, uint32_t depth);
+
+    /**
+     * Parse a selector
+     * @param selector - selector text
+     * @return - steps from outermost to innermost
+     */
+    vector<Step> parse(string_view selector) const;
+
+    /**
+     * Whether a node satisfies one step, without checking its ancestors
+     * @param node - index of node
+     * @param step - step
+     * @return - result
+     */
+    bool matches(uint32_t node, const Step &step) const;
+
+    /**
+     * Whether ancestors of a node matching a step satisfy the steps before it
+     * @param node - index of node
+     * @param steps - steps of selector
+     * @param step - index of step matched by node
+     * @return - result
+     */
+    bool matchesAncestors(uint32_t node, const vector<Step> &steps, size_t step) const;
+
+public:
+    /**
+     * index of no node, e.g. parent of root
+     */
+    static constexpr uint32_t none = UINT32_MAX;
+
+    /**
+     * kind id of a kind not in tree
+     */
+    static constexpr uint32_t unknown = UINT32_MAX;
+
+    /**
+     * Constructor of class
+     * @param root - JSON tree of program
+     */
+    explicit AstIndex(const json &root);
+
+    /**
+     * Number of nodes
+     * @return - number of nodes
+     */
+    size_t size() const;
+
+    /**
+     * Node by index
+     * @param index - index of node in preorder
+     * @return - node
+     */
+    const AstNode &node(uint32_t index) const;
+
+    /**
+     * Bit of a kind id in set of kinds, kinds beyond 63 share the last bit
+     * @param kind - id of kind
+     * @return - bit
+     */
+    static uint64_t kindBit(uint32_t kind);
+
+    /**
+     * Id of a kind
+     * @param kind - kind of node
+     * @return - id, unknown if no node has the kind
+     */
+    uint32_t kindId(const string &kind) const;
+
+    /**
+     * Name of a kind id
+     * @param id - id of kind
+     * @return - kind of node
+     */
+    const string &kindName(uint32_t id) const;
+
+    /**
+     * Number of distinct kinds
+     * @return - number of kinds
+     */
+    size_t kinds() const;
+
+    /**
+     * Nodes of a kind
+     * @param kind - kind of node
+     * @return - indexes of nodes in preorder
+     */
+    const vector<uint32_t> &ofKind(const string &kind) const;
+
+    /**
+     * Whether a node is inside the subtree of another
+     * @param ancestor - index of ancestor
+     * @param node - index of node
+     * @return - result
+     */
+    bool contains(uint32_t ancestor, uint32_t node) const;
+
+    /**
+     * Find nodes matching a selector.
+     * A selector is a list of kinds, "*" for any kind, separated by " " for descendants or ">" for children.
+     * Each kind may be followed by conditions on fields, [field], [field=value] or [field!=value], where a field is
+     * a path like callee.name and a node compared with a value is compared by its name,
+     * e.g. ForStatement CallExpression[callee=malloc]
+     * @param selector - selector text
+     * @return - indexes of matching nodes in preorder
+     */
+    vector<uint32_t> select(string_view selector) const;
+};
+
+#endif //PARSER_QUERY_HPP
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "headers.hpp"
+#include "pool.hpp"
+#include "repository.hpp"
+
+/**
+ * Constructor of class
+ * @param options - options of parsing each file
+ * @param threads - number of threads, 0 for hardware concurrency
+ */
+RepositoryIndex::RepositoryIndex(ParseOptions options, unsigned threads)
+        : options(move(options)), threads(threads), parsedFiles(0), reusedFiles(0) {}
+
+/**
+ * Shard holding a name
+ * @param name - name
+ * @return - shard
+ */
+RepositoryIndex::Shard &RepositoryIndex::shard(string_view name) {
+    return shards[HeaderCache::hash(name) % shards.size()];
+}
+
+/**
+ * Merge references of all files into shards
+ */
+void RepositoryIndex::merge() {
+    for (Shard &shard: shards) {
+        shard.symbols.clear();
+    }
+    ThreadPool pool(threads);
+    pool.run(files.size(), [&](size_t index, unsigned) {
+        const IndexedFile &file = files[index];
+        for (const Reference &reference: file.references) {
+            const string &name = file.names[reference.name];
+            Shard &target = shard(name);
+            lock_guard<mutex> guard(target.lock);
+            target.symbols[name].push_back({static_cast<uint32_t>(index), reference.position, reference.kind});
+        }
+    });
+    // files are merged in any order, sorting makes results independent of scheduling
+    pool.run(shards.size(), [&](size_t index, unsigned) {
+        for (auto &symbol: shards[index].symbols) {
+            sort(symbol.second.begin(), symbol.second.end(), [](const Location &a, const Location &b) {
+                return a.file != b.file ? a.file < b.file : a.line < b.line;
+            });
+        }
+    });
+}
+
+/**
+ * Hash of the parse options that change the references of a file
+ * @return - 64-bit hash
+ */
+uint64_t RepositoryIndex::fingerprint() const {
+    return HeaderCache::fingerprint(options);
+}
+
+/**
+ * Load index saved by a previous run, a missing file or one saved with other parse options leaves index empty
+ * @param path - path of index
+ */
+void RepositoryIndex::load(const string &path) {
+    files.clear();
+    ifstream input(path, ios::binary);
+    if (!input.is_open()) {
+        merge();
+        return;
+    }
+    vector<uint8_t> bytes((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    json saved = json::from_cbor(bytes);
+    // records of another format or of other options would be reused with wrong references
+    if (saved.value("version", 0) != 2 || saved.value("options", uint64_t(0)) != fingerprint()) {
+        merge();
+        return;
+    }
+    for (const json &entry: saved["files"]) {
+        IndexedFile file;
+        file.path = entry["path"];
+        file.hash = entry["hash"];
+        file.error = entry["error"];
+        file.names = entry["names"].get<vector<string>>();
+        // references are flattened as name, function, line and kind
+        const json &references = entry["references"];
+        for (size_t i = 0; i + 3 < references.size(); i += 4) {
+            int64_t function = references[i + 1];
+            file.references.push_back({
+                    references[i].get<uint32_t>(),
+                    function < 0 ? CrossReference::none : static_cast<uint32_t>(function),
+                    references[i + 2].get<int>(),
+                    static_cast<ReferenceKind>(references[i + 3].get<int>())
+            });
+        }
+        files.push_back(move(file));
+    }
+    merge();
+}
+
+/**
+ * Save index as CBOR
+ * @param path - path of index
+ */
+void RepositoryIndex::save(const string &path) const {
+    json list = json::array();
+    for (const IndexedFile &file: files) {
+        json references = json::array();
+        for (const Reference &reference: file.references) {
+            references.push_back(reference.name);
+            references.push_back(reference.function == CrossReference::none ? -1 : int64_t(reference.function));
+            references.push_back(reference.position);
+            references.push_back(static_cast<int>(reference.kind));
+        }
+        list.push_back({
+                {"path",       file.path},
+                {"hash",       file.hash},
+                {"error",      file.error},
+                {"names",      file.names},
+                {"references", references}
+        });
+    }
+    vector<uint8_t> bytes = json::to_cbor(json{{"version", 2}, {"options", fingerprint()}, {"files", list}});
+    ofstream output(path, ios::binary);
+    output.write(reinterpret_cast<const char *>(bytes.data()), static_cast<streamsize>(bytes.size()));
+    if (!output) {
+        throw runtime_error("Cannot write " + path);
+    }
+}
+
+/**
+ * Index all C files under roots, parsing only new and changed files
+ * @param roots - files or directories
+ */
+void RepositoryIndex::build(const vector<string> &roots) {
+    vector<string> paths;
+    for (const string &root: roots) {
+        if (filesystem::is_directory(root)) {
+            for (const auto &entry: filesystem::recursive_directory_iterator(root)) {
+                string extension = entry.path().extension().string();
+                if (entry.is_regular_file() && (extension == ".c" || extension == ".h")) {
+                    paths.push_back(entry.path().lexically_normal().string());
+                }
+            }
+        } else {
+            paths.push_back(filesystem::path(root).lexically_normal().string());
+        }
+    }
+    sort(paths.begin(), paths.end());
+    paths.erase(unique(paths.begin(), paths.end()), paths.end());
+
+    unordered_map<string, IndexedFile *> previous;
+    for (IndexedFile &file: files) {
+        previous.emplace(file.path, &file);
+    }
+    vector<IndexedFile> updated(paths.size());
+    vector<char> isReused(paths.size(), 0);
+    ThreadPool pool(threads);
+    pool.run(paths.size(), [&](size_t index, unsigned) {
+        IndexedFile &file = updated[index];
+        file.path = paths[index];
+        ifstream input(file.path, ios::binary);
+        stringstream buffer;
+        buffer << input.rdbuf();
+        string content = buffer.str();
+        file.hash = HeaderCache::hash(content);
+        auto found = previous.find(file.path);
+        if (found != previous.end() && found->second->hash == file.hash) {
+            file = move(*found->second);
+            isReused[index] = 1;
+            return;
+        }
+        if (!input.is_open()) {
+            file.error = "Cannot open " + file.path;
+            return;
+        }
+        try {
+            ParseOptions fileOptions = options;
+            fileOptions.directory = filesystem::path(file.path).parent_path().string();
+            if (fileOptions.directory.empty()) {
+                fileOptions.directory = ".";
+            }
+            CrossReference index(Parser(move(content), fileOptions).parse());
+            for (size_t id = 0; id < index.size(); id++) {
+                file.names.push_back(index.name(static_cast<uint32_t>(id)));
+            }
+            file.references = index.entries();
+        } catch (exception &e) {
+            file.error = e.what();
+        }
+    });
+    files = move(updated);
+    reusedFiles = static_cast<size_t>(count(isReused.begin(), isReused.end(), 1));
+    parsedFiles = files.size() - reusedFiles;
+    merge();
+}
+
+/**
+ * References to a name in all files
+ * @param name - name
+ * @return - references ordered by file and line
+ */
+vector<Location> RepositoryIndex::find(const string &name) {
+    Shard &target = shard(name);
+    lock_guard<mutex> guard(target.lock);
+    auto found = target.symbols.find(name);
+    return found == target.symbols.end() ? vector<Location>() : found->second;
+}
+
+/**
+ * Indexed files
+ * @return - files ordered by path
+ */
+const vector<IndexedFile> &RepositoryIndex::indexedFiles() const {
+    return files;
+}
+
+/**
+ * Number of files parsed by last build
+ * @return - number of files
+ */
+size_t RepositoryIndex::parsed() const {
+    return parsedFiles;
+}
+
+/**
+ * Number of files reused from loaded index by last build
+ * @return - number of files
+ */
+size_t RepositoryIndex::reused() const {
+    return reusedFiles;
+}
+
+/**
+ * Number of distinct names
+ * @return - number of names
+ */
+size_t RepositoryIndex::size() {
+    size_t total = 0;
+    for (Shard &shard: shards) {
+        lock_guard<mutex> guard(shard.lock);
+        total += shard.symbols.size();
+    }
+    return total;
+}
@@ -0,0 +1,124 @@
+#ifndef PARSER_REPOSITORY_HPP
+#define PARSER_REPOSITORY_HPP
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include "parser.hpp"
+#include "xref.hpp"
+
+/**
+ * references of one indexed file, names being local to the file
+ */
+struct IndexedFile {
+    string path;
+    uint64_t hash;
+    string error;
+    vector<string> names;
+    vector<Reference> references;
+};
+
+/**
+ * reference to a name in a file of repository
+ */
+struct Location {
+    uint32_t file;
+    int line;
+    ReferenceKind kind;
+};
+
+/**
+ * Index of names over all files of a repository.
+ * Files are parsed in parallel and merged into hash maps sharded by name, and a file whose content hash
+ * has not changed since the saved index is not parsed again
+ */
+class RepositoryIndex {
+    struct Shard {
+        mutex lock;
+        unordered_map<string, vector<Location>> symbols;
+    };
+
+    ParseOptions options;
+    unsigned threads;
+    vector<IndexedFile> files;
+    array<Shard, 64> shards;
+    size_t parsedFiles;
+    size_t reusedFiles;
+
+    /**
+     * Shard holding a name
+     * @param name - name
+     * @return - shard
+     */
+    Shard &shard(string_view name);
+
+    /**
+     * Merge references of all files into shards
+     */
+    void merge();
+
+    /**
+     * Hash of the parse options that change the references of a file
+     * @return - 64-bit hash
+     */
+    uint64_t fingerprint() const;
+
+public:
+    /**
+     * Constructor of class
+     * @param options - options of parsing each file
+     * @param threads - number of threads, 0 for hardware concurrency
+     */
+    explicit RepositoryIndex(ParseOptions options = ParseOptions(), unsigned threads = 0);
+
+    /**
+     * Load index saved by a previous run, a missing file or one saved with other parse options leaves index empty
+     * @param path - path of index
+     */
+    void load(const string &path);
+
+    /**
+     * Save index as CBOR
+     * @param path - path of index
+     */
+    void save(const string &path) const;
+
+    /**
+     * Index all C files under roots, parsing only new and changed files
+     * @param roots - files or directories
+     */
+    void build(const vector<string> &roots);
+
+    /**
+     * References to a name in all files
+     * @param name - name
+     * @return - references ordered by file and line
+     */
+    vector<Location> find(const string &name);
+
+    /**
+     * Indexed files
+     * @return - files ordered by path
+     */
+    const vector<IndexedFile> &indexedFiles() const;
+
+    /**
+     * Number of files parsed by last build
+     * @return - number of files
+     */
+    size_t parsed() const;
+
+    /**
+     * Number of files reused from loaded index by last build
+     * @return - number of files
+     */
+    size_t reused() const;
+
+    /**
+     * Number of distinct names
+     * @return - number of names
+     */
+    size_t size();
+};
+
+#endif //PARSER_REPOSITORY_HPP
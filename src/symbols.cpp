@@ -0,0 +1,162 @@
+#include "symbols.hpp"
+
+/**
+ * Constructor of class
+ * @param name - declared name
+ * @param kind - kind of name
+ * @param position - line number of declaration
+ * @param depth - depth of scope
+ * @param shadowed - index of shadowed symbol
+ * @param allocator - allocator of name
+ */
+Symbol::Symbol(string_view name, SymbolKind kind, int position, unsigned depth, size_t shadowed,
+               const allocator_type &allocator)
+        : name(name, allocator), kind(kind), position(position), depth(depth), shadowed(shadowed) {}
+
+/**
+ * Copy constructor of class
+ * @param symbol - symbol to be copied
+ * @param allocator - allocator of name
+ */
+Symbol::Symbol(const Symbol &symbol, const allocator_type &allocator)
+        : name(symbol.name, allocator), kind(symbol.kind), position(symbol.position), depth(symbol.depth),
+          shadowed(symbol.shadowed) {}
+
+/**
+ * Move constructor of class
+ * @param symbol - symbol to be moved
+ * @param allocator - allocator of name
+ */
+Symbol::Symbol(Symbol &&symbol, const allocator_type &allocator)
+        : name(move(symbol.name), allocator), kind(symbol.kind), position(symbol.position), depth(symbol.depth),
+          shadowed(symbol.shadowed) {}
+
+SymbolTable::SymbolTable(pmr::memory_resource *memory)
+        : symbols(memory), scopes(memory), visible(memory), declared(memory) {}
+
+/**
+ * Open a nested scope
+ */
+void SymbolTable::enterScope() {
+    scopes.push_back(symbols.size());
+}
+
+/**
+ * Close innermost scope, making names shadowed by its symbols visible again
+ */
+void SymbolTable::leaveScope() {
+    size_t mark = scopes.back();
+    scopes.pop_back();
+    while (symbols.size() > mark) {
+        const Symbol &symbol = symbols.back();
+        // the key views the name of the symbol being dropped, so it is inserted again for the shadowed one
+        visible.erase(symbol.name);
+        if (symbol.shadowed != none) {
+            visible.emplace(symbols[symbol.shadowed].name, symbol.shadowed);
+        }
+        symbols.pop_back();
+    }
+}
+
+/**
+ * Depth of innermost scope, 0 for file scope
+ * @return - depth
+ */
+unsigned SymbolTable::depth() const {
+    return static_cast<unsigned>(scopes.size());
+}
+
+/**
+ * Declare a name in innermost scope
+ * @param name - declared name
+ * @param kind - kind of name
+ * @param position - line number of declaration
+ */
+void SymbolTable::declare(string_view name, SymbolKind kind, int position) {
+    auto found = visible.find(name);
+    size_t shadowed = found == visible.end() ? none : found->second;
+    symbols.emplace_back(name, kind, position, depth(), shadowed);
+    if (found != visible.end()) {
+        visible.erase(found);
+    }
+    visible.emplace(symbols.back().name, symbols.size() - 1);
+    declared.push_back(symbols.back());
+}
+
+/**
+ * Find visible symbol of a name
+ * @param name - name to be found
+ * @return - innermost symbol, nullptr if not declared
+ */
+const Symbol *SymbolTable::lookup(string_view name) const {
+    auto found = visible.find(name);
+    return found == visible.end() ? nullptr : &symbols[found->second];
+}
+
+/**
+ * Whether a name is a visible type name
+ * @param name - name to be checked
+ * @return - result
+ */
+bool SymbolTable::isType(string_view name) const {
+    const Symbol *symbol = lookup(name);
+    return symbol && symbol->kind == SymbolKind::Type;
+}
+
+/**
+ * Keep current symbols, such as builtin types, across clear
+ */
+void SymbolTable::seal() {
+    permanent = symbols.size();
+    declared.clear();
+}
+
+/**
+ * Forget all symbols declared after seal
+ */
+void SymbolTable::clear() {
+    scopes.clear();
+    scopes.push_back(permanent);
+    leaveScope();
+    declared.clear();
+}
+
+/**
+ * Get type names declared in file scope
+ * @return - type names in order of declaration
+ */
+vector<string> SymbolTable::types() const {
+    vector<string> names;
+    for (const Symbol &symbol: declared) {
+        if (symbol.kind == SymbolKind::Type && symbol.depth == 0) {
+            names.emplace_back(symbol.name);
+        }
+    }
+    return names;
+}
+
+/**
+ * Get every declaration since seal, including those of closed scopes
+ * @return - symbols in order of declaration
+ */
+const pmr::vector<Symbol> &SymbolTable::declarations() const {
+    return declared;
+}
+
+/**
+ * Convert declarations to JSON
+ * @return - array of name, kind, position and depth of declarations
+ */
+json SymbolTable::toJson() const {
+    static const char *kinds[] = {"type", "variable", "function", "constant", "tag"};
+    json list = json::array();
+    for (const Symbol &symbol: declared) {
+        list.push_back({
+                {"name",     string(symbol.name)},
+                {"kind",     kinds[static_cast<size_t>(symbol.kind)]},
+                {"position", symbol.position},
+                {"depth",    symbol.depth}
+        });
+    }
+    return list;
+}
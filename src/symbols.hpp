@@ -0,0 +1,163 @@
+#ifndef PARSER_SYMBOLS_HPP
+#define PARSER_SYMBOLS_HPP
+
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "../lib/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * kind of declared name
+ */
+enum class SymbolKind : uint8_t {
+    Type,
+    Variable,
+    Function,
+    Constant,
+    Tag
+};
+
+/**
+ * name declared in a scope, allocating its name from the memory resource of the containing table
+ */
+struct Symbol {
+    using allocator_type = pmr::polymorphic_allocator<char>;
+
+    pmr::string name;
+    SymbolKind kind;
+    int position;
+    unsigned depth;
+    size_t shadowed;
+
+    /**
+     * Constructor of class
+     * @param name - declared name
+     * @param kind - kind of name
+     * @param position - line number of declaration
+     * @param depth - depth of scope
+     * @param shadowed - index of shadowed symbol
+     * @param allocator - allocator of name
+     */
+    Symbol(string_view name, SymbolKind kind, int position, unsigned depth, size_t shadowed,
+           const allocator_type &allocator = {});
+
+    /**
+     * Copy constructor of class
+     * @param symbol - symbol to be copied
+     * @param allocator - allocator of name
+     */
+    Symbol(const Symbol &symbol, const allocator_type &allocator = {});
+
+    /**
+     * Move constructor of class
+     * @param symbol - symbol to be moved
+     * @param allocator - allocator of name
+     */
+    Symbol(Symbol &&symbol, const allocator_type &allocator);
+
+    Symbol(Symbol &&symbol) = default;
+
+    Symbol &operator=(const Symbol &symbol) = default;
+
+    Symbol &operator=(Symbol &&symbol) = default;
+};
+
+/**
+ * Scoped table of declared names.
+ * Symbols of open scopes are stacked in an arena, each scope being the frame above its mark,
+ * and a hash map points every name to its innermost symbol, which links to the symbol it shadows.
+ * All containers allocate from one memory resource
+ */
+class SymbolTable {
+    pmr::deque<Symbol> symbols;
+    pmr::vector<size_t> scopes;
+    pmr::unordered_map<string_view, size_t> visible;
+    pmr::vector<Symbol> declared;
+    size_t permanent = 0;
+
+public:
+    /**
+     * index of no symbol
+     */
+    static constexpr size_t none = SIZE_MAX;
+
+    /**
+     * Constructor of class
+     * @param memory - memory resource of containers
+     */
+    explicit SymbolTable(pmr::memory_resource *memory = pmr::get_default_resource());
+
+    /**
+     * Open a nested scope
+     */
+    void enterScope();
+
+    /**
+     * Close innermost scope, making names shadowed by its symbols visible again
+     */
+    void leaveScope();
+
+    /**
+     * Depth of innermost scope, 0 for file scope
+     * @return - depth
+     */
+    unsigned depth() const;
+
+    /**
+     * Declare a name in innermost scope
+     * @param name - declared name
+     * @param kind - kind of name
+     * @param position - line number of declaration
+     */
+    void declare(string_view name, SymbolKind kind, int position);
+
+    /**
+     * Find visible symbol of a name
+     * @param name - name to be found
+     * @return - innermost symbol, nullptr if not declared
+     */
+    const Symbol *lookup(string_view name) const;
+
+    /**
+     * Whether a name is a visible type name
+     * @param name - name to be checked
+     * @return - result
+     */
+    bool isType(string_view name) const;
+
+    /**
+     * Keep current symbols, such as builtin types, across clear
+     */
+    void seal();
+
+    /**
+     * Forget all symbols declared after seal
+     */
+    void clear();
+
+    /**
+     * Get type names declared in file scope
+     * @return - type names in order of declaration
+     */
+    vector<string> types() const;
+
+    /**
+     * Get every declaration since seal, including those of closed scopes
+     * @return - symbols in order of declaration
+     */
+    const pmr::vector<Symbol> &declarations() const;
+
+    /**
+     * Convert declarations to JSON
+     * @return - array of name, kind, position and depth of declarations
+     */
+    json toJson() const;
+};
+
+#endif //PARSER_SYMBOLS_HPP
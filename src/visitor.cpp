@@ -0,0 +1,104 @@
+#include "visitor.hpp"
+
+/**
+ * Register a callback called before the subtree of each node of a kind
+ * @param kind - kind of node, "*" for every kind
+ * @param visit - callback
+ */
+void Pass::onEnter(const string &kind, Visit visit) {
+    handlers.push_back({kind, move(visit), nullptr});
+}
+
+/**
+ * Register a callback called after the subtree of each node of a kind
+ * @param kind - kind of node, "*" for every kind
+ * @param visit - callback
+ */
+void Pass::onLeave(const string &kind, Visit visit) {
+    handlers.push_back({kind, nullptr, move(visit)});
+}
+
+/**
+ * Called before traversal of a tree
+ * @param index - index of tree
+ */
+void Pass::begin(const AstIndex &) {}
+
+/**
+ * Called after traversal of a tree
+ * @param index - index of tree
+ */
+void Pass::end(const AstIndex &) {}
+
+/**
+ * Add a pass, which must outlive the traversal
+ * @param pass - pass
+ * @return - this traversal
+ */
+Traversal &Traversal::add(Pass &pass) {
+    passes.push_back(&pass);
+    return *this;
+}
+
+/**
+ * Run all passes over a tree, callbacks of a node being called in the order passes were added
+ * @param index - index of tree
+ */
+void Traversal::run(const AstIndex &index) const {
+    // callbacks are resolved to kind ids of this tree once, so dispatch is an array lookup
+    vector<vector<const Visit *>> enters(index.kinds());
+    vector<vector<const Visit *>> leaves(index.kinds());
+    uint64_t wanted = 0;
+    for (Pass *pass: passes) {
+        pass->begin(index);
+        for (const Pass::Handler &handler: pass->handlers) {
+            auto subscribe = [&](uint32_t kind) {
+                if (handler.enter) {
+                    enters[kind].push_back(&handler.enter);
+                }
+                if (handler.leave) {
+                    leaves[kind].push_back(&handler.leave);
+                }
+                wanted |= AstIndex::kindBit(kind);
+            };
+            if (handler.kind == "*") {
+                for (uint32_t kind = 0; kind < index.kinds(); kind++) {
+                    subscribe(kind);
+                }
+            } else if (index.kindId(handler.kind) != AstIndex::unknown) {
+                subscribe(index.kindId(handler.kind));
+            }
+        }
+    }
+    // nodes waiting for their leave callbacks, innermost last
+    vector<uint32_t> open;
+    auto close = [&](uint32_t until) {
+        while (!open.empty() && index.node(open.back()).end <= until) {
+            uint32_t node = open.back();
+            open.pop_back();
+            for (const Visit *visit: leaves[index.node(node).kind]) {
+                (*visit)(index, node);
+            }
+        }
+    };
+    auto size = static_cast<uint32_t>(index.size());
+    for (uint32_t node = 0; node < size;) {
+        close(node);
+        const AstNode &current = index.node(node);
+        if ((current.kinds & wanted) == 0) {
+            node = current.end;
+            continue;
+        }
+        for (const Visit *visit: enters[current.kind]) {
+            (*visit)(index, node);
+        }
+        if (!leaves[current.kind].empty()) {
+            open.push_back(node);
+        }
+        node++;
+    }
+    close(size);
+    for (Pass *pass: passes) {
+        pass->end(index);
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef PARSER_VISITOR_HPP
+#define PARSER_VISITOR_HPP
+
+#include <functional>
+#include "query.hpp"
+
+/**
+ * callback on a node, given the index and the position of node in preorder
+ */
+using Visit = function<void(const AstIndex &index, uint32_t node)>;
+
+/**
+ * Analysis run over an AST, registering callbacks for the node kinds it cares about.
+ * A pass is run together with other passes by a Traversal
+ */
+class Pass {
+    friend class Traversal;
+
+    /**
+     * callback registered for a kind, "*" for every kind
+     */
+    struct Handler {
+        string kind;
+        Visit enter;
+        Visit leave;
+    };
+
+    vector<Handler> handlers;
+
+protected:
+    /**
+     * Register a callback called before the subtree of each node of a kind
+     * @param kind - kind of node, "*" for every kind
+     * @param visit - callback
+     */
+    void onEnter(const string &kind, Visit visit);
+
+    /**
+     * Register a callback called after the subtree of each node of a kind
+     * @param kind - kind of node, "*" for every kind
+     * @param visit - callback
+     */
+    void onLeave(const string &kind, Visit visit);
+
+public:
+    virtual ~Pass() = default;
+
+    /**
+     * Called before traversal of a tree
+     * @param index - index of tree
+     */
+    virtual void begin(const AstIndex &index);
+
+    /**
+     * Called after traversal of a tree
+     * @param index - index of tree
+     */
+    virtual void end(const AstIndex &index);
+};
+
+/**
+ * Runs several passes in a single preorder walk of an AstIndex.
+ * Callbacks are dispatched by kind id, and a subtree containing no kind wanted by any pass is skipped
+ * as a whole, so adding a pass costs its callbacks rather than another walk
+ */
+class Traversal {
+    vector<Pass *> passes;
+
+public:
+    /**
+     * Add a pass, which must outlive the traversal
+     * @param pass - pass
+     * @return - this traversal
+     */
+    Traversal &add(Pass &pass);
+
+    /**
+     * Run all passes over a tree, callbacks of a node being called in the order passes were added
+     * @param index - index of tree
+     */
+    void run(const AstIndex &index) const;
+};
+
+#endif //PARSER_VISITOR_HPP
@@ -0,0 +1,225 @@
+#include <charconv>
+#include <stdexcept>
+#include "writer.hpp"
+
+/**
+ * Byte as two hexadecimal digits
+ * @param byte - byte
+ * @return - digits
+ */
+static string hexByte(char byte) {
+    static const char digits[] = "0123456789ABCDEF";
+    auto value = static_cast<unsigned char>(byte);
+    return {digits[value >> 4], digits[value & 15]};
+}
+
+/**
+ * Length of the UTF-8 sequence of a non-ASCII character, rejecting overlong forms, surrogates
+ * and code points above U+10FFFF
+ * @param text - text
+ * @param begin - position of first byte
+ * @return - length of sequence
+ */
+static size_t sequenceLength(const string &text, size_t begin) {
+    auto lead = static_cast<unsigned char>(text[begin]);
+    size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        low = lead == 0xE0 ? 0xA0 : low;
+        high = lead == 0xED ? 0x9F : high;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        low = lead == 0xF0 ? 0x90 : low;
+        high = lead == 0xF4 ? 0x8F : high;
+    } else {
+        throw runtime_error("invalid UTF-8 byte at index " + to_string(begin) + ": 0x" + hexByte(text[begin]));
+    }
+    for (size_t i = begin + 1; i < begin + length; i++) {
+        if (i >= text.size()) {
+            throw runtime_error("incomplete UTF-8 string; last byte: 0x" + hexByte(text.back()));
+        }
+        auto byte = static_cast<unsigned char>(text[i]);
+        if (byte < low || byte > high) {
+            throw runtime_error("invalid UTF-8 byte at index " + to_string(i) + ": 0x" + hexByte(text[i]));
+        }
+        low = 0x80;
+        high = 0xBF;
+    }
+    return length;
+}
+
+/**
+ * Constructor of class
+ * @param out - output stream
+ * @param indent - spaces per nesting level, negative for compact output
+ */
+JsonWriter::JsonWriter(ostream &out, int indent) : out(out), indent(indent) {
+    buffer.reserve(bufferSize + 256);
+}
+
+/**
+ * Destructor of class, writes what is left in buffer
+ */
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+/**
+ * Start a line at a nesting level in pretty output
+ * @param depth - nesting level
+ */
+void JsonWriter::newline(int depth) {
+    if (indent >= 0) {
+        buffer.push_back('\n');
+        buffer.append(static_cast<size_t>(depth * indent), ' ');
+    }
+}
+
+/**
+ * Write a string literal with its quotes
+ * @param text - UTF-8 string
+ */
+void JsonWriter::writeString(const string &text) {
+    buffer.push_back('"');
+    // runs of characters needing no escape are copied at once
+    size_t run = 0;
+    for (size_t i = 0; i < text.size();) {
+        auto byte = static_cast<unsigned char>(text[i]);
+        if (byte >= 0x80) {
+            i += sequenceLength(text, i);
+            continue;
+        }
+        if (byte >= 0x20 && byte != '"' && byte != '\\') {
+            i++;
+            continue;
+        }
+        buffer.append(text, run, i - run);
+        switch (byte) {
+            case '"':
+                buffer += "\\\"";
+                break;
+            case '\\':
+                buffer += "\\\\";
+                break;
+            case '\b':
+                buffer += "\\b";
+                break;
+            case '\t':
+                buffer += "\\t";
+                break;
+            case '\n':
+                buffer += "\\n";
+                break;
+            case '\f':
+                buffer += "\\f";
+                break;
+            case '\r':
+                buffer += "\\r";
+                break;
+            default:
+                buffer += "\\u00";
+                buffer += static_cast<char>('0' + (byte >> 4));
+                buffer += "0123456789abcdef"[byte & 15];
+        }
+        run = ++i;
+    }
+    buffer.append(text, run, string::npos);
+    buffer.push_back('"');
+}
+
+/**
+ * Write a value
+ * @param value - JSON value
+ * @param depth - nesting level of value in the enclosing document
+ */
+void JsonWriter::write(const json &value, int depth) {
+    char digits[24];
+    switch (value.type()) {
+        case json::value_t::object: {
+            const auto &object = value.get_ref<const json::object_t &>();
+            if (object.empty()) {
+                buffer += "{}";
+                break;
+            }
+            buffer.push_back('{');
+            for (auto item = object.begin(); item != object.end(); ++item) {
+                if (item != object.begin()) {
+                    buffer.push_back(',');
+                }
+                newline(depth + 1);
+                writeString(item->first);
+                buffer += indent >= 0 ? ": " : ":";
+                write(item->second, depth + 1);
+            }
+            newline(depth);
+            buffer.push_back('}');
+            break;
+        }
+        case json::value_t::array: {
+            const auto &array = value.get_ref<const json::array_t &>();
+            if (array.empty()) {
+                buffer += "[]";
+                break;
+            }
+            buffer.push_back('[');
+            for (auto item = array.begin(); item != array.end(); ++item) {
+                if (item != array.begin()) {
+                    buffer.push_back(',');
+                }
+                newline(depth + 1);
+                write(*item, depth + 1);
+            }
+            newline(depth);
+            buffer.push_back(']');
+            break;
+        }
+        case json::value_t::string:
+            writeString(value.get_ref<const string &>());
+            break;
+        case json::value_t::boolean:
+            buffer += value.get<bool>() ? "true" : "false";
+            break;
+        case json::value_t::number_integer:
+            buffer.append(digits, to_chars(digits, digits + sizeof digits, value.get<int64_t>()).ptr);
+            break;
+        case json::value_t::number_unsigned:
+            buffer.append(digits, to_chars(digits, digits + sizeof digits, value.get<uint64_t>()).ptr);
+            break;
+        case json::value_t::number_float:
+            // shortest round-trip form of dump
+            buffer += value.dump();
+            break;
+        case json::value_t::discarded:
+            buffer += "<discarded>";
+            break;
+        case json::value_t::null:
+            buffer += "null";
+            break;
+    }
+    if (buffer.size() >= bufferSize) {
+        flush();
+    }
+}
+
+/**
+ * Write text as it is, e.g. punctuation of a document whose values are written one by one
+ * @param text - text
+ */
+void JsonWriter::raw(string_view text) {
+    buffer.append(text);
+    if (buffer.size() >= bufferSize) {
+        flush();
+    }
+}
+
+/**
+ * Write buffered text to stream
+ */
+void JsonWriter::flush() {
+    out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    buffer.clear();
+}
@@ -0,0 +1,69 @@
+#ifndef PARSER_WRITER_HPP
+#define PARSER_WRITER_HPP
+
+#include <ostream>
+#include "../lib/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * Serializer writing a JSON tree straight to a stream through a fixed-size buffer, without building
+ * the whole text first. Output is byte for byte the one of dump, compact or pretty, and strings
+ * must be valid UTF-8 as they must for dump
+ */
+class JsonWriter {
+    /**
+     * number of buffered bytes that triggers a write to stream
+     */
+    static constexpr size_t bufferSize = 1 << 16;
+
+    ostream &out;
+    int indent;
+    string buffer;
+
+    /**
+     * Start a line at a nesting level in pretty output
+     * @param depth - nesting level
+     */
+    void newline(int depth);
+
+    /**
+     * Write a string literal with its quotes
+     * @param text - UTF-8 string
+     */
+    void writeString(const string &text);
+
+public:
+    /**
+     * Constructor of class
+     * @param out - output stream
+     * @param indent - spaces per nesting level, negative for compact output
+     */
+    explicit JsonWriter(ostream &out, int indent = -1);
+
+    /**
+     * Destructor of class, writes what is left in buffer
+     */
+    ~JsonWriter();
+
+    /**
+     * Write a value
+     * @param value - JSON value
+     * @param depth - nesting level of value in the enclosing document
+     */
+    void write(const json &value, int depth = 0);
+
+    /**
+     * Write text as it is, e.g. punctuation of a document whose values are written one by one
+     * @param text - text
+     */
+    void raw(string_view text);
+
+    /**
+     * Write buffered text to stream
+     */
+    void flush();
+};
+
+#endif //PARSER_WRITER_HPP
@@ -0,0 +1,332 @@
+#include <algorithm>
+#include "xref.hpp"
+
+/**
+ * Constructor of class
+ * @param program - JSON tree of program
+ */
+CrossReference::CrossReference(const json &program) : function(none) {
+    walk(program);
+    build();
+}
+
+/**
+ * Id of a name while walking
+ * @param name - name
+ * @return - id
+ */
+uint32_t CrossReference::intern(const string &name) {
+    auto found = ids.find(name);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    names.push_back(name);
+    ids.emplace(name, static_cast<uint32_t>(names.size() - 1));
+    return static_cast<uint32_t>(names.size() - 1);
+}
+
+/**
+ * Record a reference while walking
+ * @param name - name referred to
+ * @param position - line number
+ * @param kind - kind of reference
+ */
+void CrossReference::add(const string &name, int position, ReferenceKind kind) {
+    uint32_t id = intern(name);
+    references.push_back({id, function, position, kind});
+    if (kind == ReferenceKind::Call && function != none) {
+        calls.emplace_back(function, id);
+    }
+}
+
+/**
+ * Walk children of a node except some fields
+ * @param node - JSON tree
+ * @param skipped - fields not walked
+ */
+void CrossReference::walkChildren(const json &node, initializer_list<const char *> skipped) {
+    for (auto item = node.begin(); item != node.end(); ++item) {
+        if (item.value().is_structured()
+            && none_of(skipped.begin(), skipped.end(), [&](const char *key) { return item.key() == key; })) {
+            walk(item.value());
+        }
+    }
+}
+
+/**
+ * Walk a subtree
+ * @param node - JSON tree
+ */
+void CrossReference::walk(const json &node) {
+    if (node.is_array()) {
+        for (const json &item: node) {
+            walk(item);
+        }
+        return;
+    }
+    if (!node.is_object()) {
+        return;
+    }
+    auto kindField = node.find("kind");
+    if (kindField == node.end()) {
+        return;
+    }
+    const string &kind = kindField->get_ref<const string &>();
+    int position = node.value("position", 0);
+    if (kind == "Identifier") {
+        add(node["name"], position, ReferenceKind::Use);
+    } else if (kind == "CallExpression") {
+        const json &callee = node["callee"];
+        if (callee.is_object() && callee.value("kind", "") == "Identifier") {
+            add(callee["name"], callee.value("position", position), ReferenceKind::Call);
+        } else {
+            walk(callee);
+        }
+        walk(node["arguments"]);
+    } else if (kind == "BinaryExpression" && (node["operator"] == "." || node["operator"] == "->")) {
+        walk(node["left"]); // member names are not ordinary identifiers
+    } else if (kind == "FunctionDefinition" || kind == "FunctionDeclaration") {
+        bool isDefinition = kind == "FunctionDefinition";
+        const json &identifier = node["identifier"];
+        add(identifier["name"], identifier.value("position", position),
+            isDefinition ? ReferenceKind::Definition : ReferenceKind::Declaration);
+        walk(node["type"]);
+        uint32_t enclosing = function;
+        if (isDefinition) {
+            function = intern(identifier["name"]);
+        }
+        walkChildren(node, {"identifier", "type"});
+        function = enclosing;
+    } else if (kind == "Type") {
+        // builtin types are keywords, other names are typedefs or tags, a bare tag keyword is an anonymous tag
+        static const vector<string> builtins = {"void", "char", "short", "int", "long", "float", "double",
+                                                "signed", "unsigned", "const", "struct", "union", "enum"};
+        const string &name = node["name"].get_ref<const string &>();
+        auto definition = node.find("definition");
+        if (definition != node.end() && !definition->is_null()) {
+            walk(*definition);
+        } else if (std::find(builtins.begin(), builtins.end(), name) == builtins.end()) {
+            add(name, position, ReferenceKind::Use);
+        }
+    } else if (kind == "StructDefinition" || kind == "UnionDefinition" || kind == "EnumDefinition"
+               || kind == "StructDeclaration" || kind == "UnionDeclaration" || kind == "EnumDeclaration") {
+        const json &identifier = node["identifier"];
+        if (!identifier.is_null()) {
+            string keyword = kind.rfind("Struct", 0) == 0 ? "struct " : kind.rfind("Union", 0) == 0 ? "union " : "enum ";
+            add(keyword + identifier["name"].get<string>(), identifier.value("position", position),
+                kind.find("Definition") != string::npos ? ReferenceKind::Definition : ReferenceKind::Declaration);
+        }
+        walkChildren(node, {"identifier"});
+    } else if (kind == "MemberDeclaration" || kind == "ArrayMemberDeclaration") {
+        walkChildren(node, {"identifier"});
+    } else if (node.find("identifier") != node.end() && node.find("type") != node.end()) {
+        // variables, parameters and typedefs
+        const json &identifier = node["identifier"];
+        add(identifier["name"], identifier.value("position", position), ReferenceKind::Definition);
+        walkChildren(node, {"identifier"});
+    } else if (kind == "EnumMember" || kind == "PredefineStatement") {
+        const json &identifier = node["identifier"];
+        add(identifier["name"], identifier.value("position", position), ReferenceKind::Definition);
+        walkChildren(node, {"identifier"});
+    } else if (kind != "InlineComment" && kind != "BlockComment" && kind != "IncludeStatement") {
+        walkChildren(node);
+    }
+}
+
+/**
+ * Sort names and references into the final arrays
+ */
+void CrossReference::build() {
+    // ids are renumbered in name order
+    vector<uint32_t> order(names.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return names[a] < names[b]; });
+    vector<uint32_t> rank(names.size());
+    vector<string> sorted(names.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        rank[order[i]] = i;
+        sorted[i] = move(names[order[i]]);
+    }
+    names = move(sorted);
+    ids.clear();
+    for (Reference &reference: references) {
+        reference.name = rank[reference.name];
+        if (reference.function != none) {
+            reference.function = rank[reference.function];
+        }
+    }
+    stable_sort(references.begin(), references.end(), [](const Reference &a, const Reference &b) {
+        return a.name != b.name ? a.name < b.name : a.position < b.position;
+    });
+    offsets.assign(names.size() + 1, 0);
+    for (const Reference &reference: references) {
+        offsets[reference.name + 1]++;
+    }
+    for (size_t i = 1; i < offsets.size(); i++) {
+        offsets[i] += offsets[i - 1];
+    }
+    byPosition.resize(references.size());
+    for (uint32_t i = 0; i < byPosition.size(); i++) {
+        byPosition[i] = i;
+    }
+    stable_sort(byPosition.begin(), byPosition.end(), [&](uint32_t a, uint32_t b) {
+        return references[a].position < references[b].position;
+    });
+    for (auto &call: calls) {
+        call = {rank[call.first], rank[call.second]};
+    }
+    sort(calls.begin(), calls.end());
+    calls.erase(unique(calls.begin(), calls.end()), calls.end());
+    calledBy.reserve(calls.size());
+    for (const auto &call: calls) {
+        calledBy.emplace_back(call.second, call.first);
+    }
+    sort(calledBy.begin(), calledBy.end());
+}
+
+/**
+ * Range of references of a name
+ * @param name - name
+ * @return - first and last index of references
+ */
+pair<uint32_t, uint32_t> CrossReference::range(string_view name) const {
+    auto found = lower_bound(names.begin(), names.end(), name,
+                             [](const string &a, string_view b) { return string_view(a) < b; });
+    if (found == names.end() || *found != name) {
+        return {0, 0};
+    }
+    size_t id = found - names.begin();
+    return {offsets[id], offsets[id + 1]};
+}
+
+/**
+ * Name of an id
+ * @param id - id of name
+ * @return - name
+ */
+const string &CrossReference::name(uint32_t id) const {
+    return names[id];
+}
+
+/**
+ * Number of names
+ * @return - number of names
+ */
+size_t CrossReference::size() const {
+    return names.size();
+}
+
+/**
+ * All references, grouped by name
+ * @return - references
+ */
+const vector<Reference> &CrossReference::entries() const {
+    return references;
+}
+
+/**
+ * All references to a name
+ * @param name - name
+ * @return - references ordered by line
+ */
+vector<Reference> CrossReference::find(string_view name) const {
+    auto bounds = range(name);
+    return vector<Reference>(references.begin() + bounds.first, references.begin() + bounds.second);
+}
+
+/**
+ * References to a name of one kind
+ * @param name - name
+ * @param kind - kind of reference
+ * @return - references ordered by line
+ */
+vector<Reference> CrossReference::find(string_view name, ReferenceKind kind) const {
+    auto bounds = range(name);
+    vector<Reference> result;
+    for (uint32_t i = bounds.first; i < bounds.second; i++) {
+        if (references[i].kind == kind) {
+            result.push_back(references[i]);
+        }
+    }
+    return result;
+}
+
+/**
+ * References on a line
+ * @param line - line number
+ * @return - references
+ */
+vector<Reference> CrossReference::at(int line) const {
+    auto first = lower_bound(byPosition.begin(), byPosition.end(), line,
+                             [&](uint32_t index, int value) { return references[index].position < value; });
+    vector<Reference> result;
+    for (auto i = first; i != byPosition.end() && references[*i].position == line; ++i) {
+        result.push_back(references[*i]);
+    }
+    return result;
+}
+
+/**
+ * Names of one side of call edges
+ * @param edges - edges sorted by first name
+ * @param name - name on first side
+ * @return - names on second side
+ */
+vector<string> CrossReference::adjacent(const vector<pair<uint32_t, uint32_t>> &edges, string_view name) const {
+    auto found = lower_bound(names.begin(), names.end(), name,
+                             [](const string &a, string_view b) { return string_view(a) < b; });
+    vector<string> result;
+    if (found == names.end() || *found != name) {
+        return result;
+    }
+    auto id = static_cast<uint32_t>(found - names.begin());
+    auto first = lower_bound(edges.begin(), edges.end(), make_pair(id, 0u));
+    for (auto edge = first; edge != edges.end() && edge->first == id; ++edge) {
+        result.push_back(names[edge->second]);
+    }
+    return result;
+}
+
+/**
+ * Functions called by a function
+ * @param function - name of caller
+ * @return - sorted names of callees
+ */
+vector<string> CrossReference::callees(string_view function) const {
+    return adjacent(calls, function);
+}
+
+/**
+ * Functions calling a function
+ * @param function - name of callee
+ * @return - sorted names of callers
+ */
+vector<string> CrossReference::callers(string_view function) const {
+    return adjacent(calledBy, function);
+}
+
+/**
+ * Convert index to JSON
+ * @return - references grouped by name and call graph
+ */
+json CrossReference::toJson() const {
+    static const char *kinds[] = {"definitions", "declarations", "uses", "calls"};
+    json symbols = json::object();
+    for (uint32_t id = 0; id < names.size(); id++) {
+        json entry = json::object();
+        for (uint32_t i = offsets[id]; i < offsets[id + 1]; i++) {
+            entry[kinds[static_cast<size_t>(references[i].kind)]].push_back(references[i].position);
+        }
+        symbols[names[id]] = entry;
+    }
+    json graph = json::object();
+    for (const auto &call: calls) {
+        graph[names[call.first]].push_back(names[call.second]);
+    }
+    return {
+            {"symbols", symbols},
+            {"calls",   graph}
+    };
+}
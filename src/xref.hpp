@@ -0,0 +1,169 @@
+#ifndef PARSER_XREF_HPP
+#define PARSER_XREF_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include "../lib/json.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * kind of reference to a name
+ */
+enum class ReferenceKind : uint8_t {
+    Definition,
+    Declaration,
+    Use,
+    Call
+};
+
+/**
+ * reference to a name at a line, inside a function or not
+ */
+struct Reference {
+    uint32_t name;
+    uint32_t function;
+    int position;
+    ReferenceKind kind;
+};
+
+/**
+ * Index of definitions, uses and calls of every name in a program, built in one traversal of its AST.
+ * Names are sorted and references are stored name by name in one array, so a name is found by binary search
+ * and its references are a contiguous range
+ */
+class CrossReference {
+    vector<string> names;
+    vector<Reference> references;
+    vector<uint32_t> offsets;
+    vector<uint32_t> byPosition;
+    vector<pair<uint32_t, uint32_t>> calls;
+    vector<pair<uint32_t, uint32_t>> calledBy;
+    unordered_map<string, uint32_t> ids;
+    uint32_t function;
+
+    /**
+     * Id of a name while walking
+     * @param name - name
+     * @return - id
+     */
+    uint32_t intern(const string &name);
+
+    /**
+     * Record a reference while walking
+     * @param name - name referred to
+     * @param position - line number
+     * @param kind - kind of reference
+     */
+    void add(const string &name, int position, ReferenceKind kind);
+
+    /**
+     * Walk a subtree
+     * @param node - JSON tree
+     */
+    void walk(const json &node);
+
+    /**
+     * Walk children of a node except some fields
+     * @param node - JSON tree
+     * @param skipped - fields not walked
+     */
+    void walkChildren(const json &node, initializer_list<const char *> skipped = {});
+
+    /**
+     * Sort names and references into the final arrays
+     */
+    void build();
+
+    /**
+     * Range of references of a name
+     * @param name - name
+     * @return - first and last index of references
+     */
+    pair<uint32_t, uint32_t> range(string_view name) const;
+
+    /**
+     * Names of one side of call edges
+     * @param edges - edges sorted by first name
+     * @param name - name on first side
+     * @return - names on second side
+     */
+    vector<string> adjacent(const vector<pair<uint32_t, uint32_t>> &edges, string_view name) const;
+
+public:
+    /**
+     * id of no name, e.g. function of a reference at file scope
+     */
+    static constexpr uint32_t none = UINT32_MAX;
+
+    /**
+     * Constructor of class
+     * @param program - JSON tree of program
+     */
+    explicit CrossReference(const json &program);
+
+    /**
+     * Name of an id
+     * @param id - id of name
+     * @return - name
+     */
+    const string &name(uint32_t id) const;
+
+    /**
+     * Number of names
+     * @return - number of names
+     */
+    size_t size() const;
+
+    /**
+     * All references, grouped by name
+     * @return - references
+     */
+    const vector<Reference> &entries() const;
+
+    /**
+     * All references to a name
+     * @param name - name
+     * @return - references ordered by line
+     */
+    vector<Reference> find(string_view name) const;
+
+    /**
+     * References to a name of one kind
+     * @param name - name
+     * @param kind - kind of reference
+     * @return - references ordered by line
+     */
+    vector<Reference> find(string_view name, ReferenceKind kind) const;
+
+    /**
+     * References on a line
+     * @param line - line number
+     * @return - references
+     */
+    vector<Reference> at(int line) const;
+
+    /**
+     * Functions called by a function
+     * @param function - name of caller
+     * @return - sorted names of callees
+     */
+    vector<string> callees(string_view function) const;
+
+    /**
+     * Functions calling a function
+     * @param function - name of callee
+     * @return - sorted names of callers
+     */
+    vector<string> callers(string_view function) const;
+
+    /**
+     * Convert index to JSON
+     * @return - references grouped by name and call graph
+     */
+    json toJson() const;
+};
+
+#endif //PARSER_XREF_HPP
@@ -0,0 +1,460 @@
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Options of generated corpus
+ */
+struct Options {
+    uint64_t seed = 1;
+    unsigned long long size = 64 * 1024;
+    long functions = -1;
+    int depth = 3;
+    int expression = 6;
+    double comments = 0.1;
+    string output;
+};
+
+/**
+ * Deterministic pseudo random generator (splitmix64), independent of the standard library
+ */
+class Random {
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    /**
+     * Next random number
+     * @return - 64 bits
+     */
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    /**
+     * Random integer in [0, bound)
+     * @param bound - upper bound
+     * @return - integer
+     */
+    int below(int bound) {
+        return bound <= 1 ? 0 : static_cast<int>(next() % static_cast<uint64_t>(bound));
+    }
+
+    /**
+     * Random event
+     * @param probability - probability of event
+     * @return - whether event happens
+     */
+    bool chance(double probability) {
+        return (next() >> 11) * (1.0 / 9007199254740992.0) < probability;
+    }
+};
+
+/**
+ * Generator of C sources accepted by the parser
+ */
+class Generator {
+    const Options &options;
+    Random random;
+    FILE *file;
+    string buffer;
+    unsigned long long written;
+    vector<string> typeNames = {"int", "char", "long", "short", "float", "double"};
+    vector<string> globals;
+    vector<pair<string, int>> arrays;
+    vector<pair<string, int>> functions;
+    vector<string> macros;
+    vector<string> locals;
+    long items;
+    long definitions;
+
+    /**
+     * Flush buffered output when it is large enough
+     * @param force - flush regardless of size
+     */
+    void flush(bool force = false) {
+        if (force || buffer.size() >= (1 << 20)) {
+            fwrite(buffer.data(), 1, buffer.size(), file);
+            written += buffer.size();
+            buffer.clear();
+        }
+    }
+
+    /**
+     * Emit indentation
+     * @param level - level of indentation
+     */
+    void indent(int level) {
+        buffer.append(static_cast<size_t>(level) * 4, ' ');
+    }
+
+    /**
+     * Pick random element
+     * @param list - candidates
+     * @return - element
+     */
+    template<typename T>
+    const T &pick(const vector<T> &list) {
+        return list[random.below(static_cast<int>(list.size()))];
+    }
+
+    /**
+     * Random word for comments and strings
+     * @return - word
+     */
+    string word() {
+        static const char *words[] = {"value", "index", "buffer", "state", "count", "table", "result", "flag",
+                                      "offset", "length", "node", "entry"};
+        return words[random.below(12)];
+    }
+
+    /**
+     * Emit a comment with configured density
+     * @param level - level of indentation
+     */
+    void comment(int level) {
+        if (!random.chance(options.comments)) {
+            return;
+        }
+        indent(level);
+        if (random.below(2)) {
+            buffer += "// " + word() + " " + word() + "\n";
+        } else {
+            buffer += "/* " + word() + " of " + word() + " */\n";
+        }
+    }
+
+    /**
+     * Random number literal of any supported notation
+     * @return - literal
+     */
+    string number() {
+        switch (random.below(8)) {
+            case 0:
+                return "0x" + string(1, "0123456789ABCDEF"[random.below(16)]) + to_string(random.below(100));
+            case 1:
+                return "0" + to_string(random.below(8)) + to_string(random.below(8));
+            case 2:
+                return to_string(random.below(1000)) + "." + to_string(random.below(100));
+            case 3:
+                return to_string(random.below(100000)) + "L";
+            case 4:
+                return to_string(random.below(100000)) + "u";
+            case 5:
+                return to_string(random.below(10)) + "." + to_string(random.below(10)) + "e-" +
+                       to_string(random.below(9) + 1);
+            default:
+                return to_string(random.below(1000));
+        }
+    }
+
+    /**
+     * Random leaf of expression
+     * @return - operand
+     */
+    string operand() {
+        int choice = random.below(10);
+        if (choice < 4 && !locals.empty()) {
+            return pick(locals);
+        } else if (choice < 5 && !globals.empty()) {
+            return pick(globals);
+        } else if (choice < 6 && !macros.empty()) {
+            return pick(macros);
+        } else if (choice < 7 && !arrays.empty()) {
+            const auto &array = pick(arrays);
+            return array.first + "[" + to_string(random.below(array.second)) + "]";
+        } else if (choice < 8) {
+            return "'" + string(1, static_cast<char>('a' + random.below(26))) + "'";
+        }
+        return number();
+    }
+
+    /**
+     * Random expression
+     * @param operands - maximum number of operands
+     * @param nesting - remaining depth of nested calls and parentheses
+     * @return - expression
+     */
+    string expression(int operands, int nesting = 2) {
+        static const char *ops[] = {"+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^", "<", ">", "<=", ">=", "==",
+                                    "!=", "&&", "||"};
+        int count = 1 + random.below(max(1, operands));
+        string result;
+        for (int i = 0; i < count; i++) {
+            if (i) {
+                result += string(" ") + ops[random.below(18)] + " ";
+            }
+            int choice = random.below(10);
+            if (nesting > 0 && choice == 0) {
+                result += "(" + expression(operands / 2 + 1, nesting - 1) + ")";
+            } else if (nesting > 0 && choice == 1 && !functions.empty()) {
+                const auto &function = pick(functions);
+                result += function.first + "(";
+                for (int j = 0; j < function.second; j++) {
+                    result += (j ? ", " : "") + expression(2, nesting - 1);
+                }
+                result += ")";
+            } else {
+                result += operand();
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Emit statements of a block
+     * @param level - level of indentation
+     * @param depth - remaining nesting depth
+     * @param inLoop - whether block is inside a loop
+     */
+    void block(int level, int depth, bool inLoop) {
+        int count = 1 + random.below(4);
+        for (int i = 0; i < count; i++) {
+            comment(level);
+            statement(level, depth, inLoop);
+        }
+    }
+
+    /**
+     * Emit a statement
+     * @param level - level of indentation
+     * @param depth - remaining nesting depth
+     * @param inLoop - whether statement is inside a loop
+     */
+    void statement(int level, int depth, bool inLoop) {
+        int choice = random.below(depth > 0 ? 10 : 5);
+        indent(level);
+        switch (choice) {
+            case 0:
+            case 1:
+                buffer += pick(locals) + " = " + expression(options.expression) + ";\n";
+                break;
+            case 2:
+                buffer += pick(locals) + " += " + expression(options.expression) + ";\n";
+                break;
+            case 3:
+                if (inLoop) {
+                    buffer += random.below(2) ? "break;\n" : "continue;\n";
+                } else {
+                    buffer += "printf(\"" + word() + " %d\\n\", " + pick(locals) + ");\n";
+                }
+                break;
+            case 4:
+                if (!functions.empty()) {
+                    const auto &function = pick(functions);
+                    buffer += function.first + "(";
+                    for (int j = 0; j < function.second; j++) {
+                        buffer += (j ? ", " : "") + expression(2, 0);
+                    }
+                    buffer += ");\n";
+                } else {
+                    buffer += pick(locals) + " = " + number() + ";\n";
+                }
+                break;
+            case 5:
+            case 6:
+                buffer += "if (" + expression(options.expression) + ") {\n";
+                block(level + 1, depth - 1, inLoop);
+                indent(level);
+                if (random.below(2)) {
+                    buffer += "} else {\n";
+                    block(level + 1, depth - 1, inLoop);
+                    indent(level);
+                }
+                buffer += "}\n";
+                break;
+            case 7: {
+                string counter = "i" + to_string(depth);
+                buffer += "for (int " + counter + " = 0; " + counter + " < " + to_string(1 + random.below(100)) +
+                          "; " + counter + " += 1) {\n";
+                locals.push_back(counter);
+                block(level + 1, depth - 1, true);
+                locals.pop_back();
+                indent(level);
+                buffer += "}\n";
+                break;
+            }
+            case 8:
+                buffer += "while (" + expression(options.expression) + ") {\n";
+                block(level + 1, depth - 1, true);
+                indent(level);
+                buffer += "}\n";
+                break;
+            default:
+                buffer += "do {\n";
+                block(level + 1, depth - 1, true);
+                indent(level);
+                buffer += "} while (" + expression(options.expression) + ");\n";
+                break;
+        }
+    }
+
+    /**
+     * Emit a function definition
+     */
+    void function() {
+        string name = "f" + to_string(items);
+        int arity = random.below(4);
+        buffer += pick(typeNames) + " " + name + "(";
+        locals.clear();
+        for (int i = 0; i < arity; i++) {
+            string param = "p" + to_string(i);
+            buffer += (i ? ", " : "") + pick(typeNames) + " " + param;
+            locals.push_back(param);
+        }
+        buffer += ") {\n";
+        int variables = 1 + random.below(4);
+        for (int i = 0; i < variables; i++) {
+            locals.push_back("v" + to_string(i));
+            indent(1);
+            buffer += pick(typeNames) + " v" + to_string(i) + " = " + number() + ";\n";
+        }
+        block(1, options.depth, false);
+        indent(1);
+        buffer += "return " + expression(options.expression) + ";\n}\n";
+        locals.clear();
+        functions.emplace_back(name, arity);
+        definitions++;
+    }
+
+    /**
+     * Emit a top-level item
+     */
+    void item() {
+        comment(0);
+        string n = to_string(items);
+        int choice = random.below(20);
+        if (choice == 0) {
+            buffer += random.below(2) ? "#include <lib" + n + ".h>\n" : "#include \"local" + n + ".h\"\n";
+        } else if (choice == 1) {
+            string name = "MACRO" + n;
+            if (random.below(2)) {
+                buffer += "#define " + name + " " + number() + "\n";
+                macros.push_back(name);
+            } else {
+                buffer += "#define " + name + "(a, b) (a * b + " + number() + ")\n";
+            }
+        } else if (choice == 2) {
+            string name = "type" + n + "_t";
+            buffer += "typedef " + pick(typeNames) + " " + name + ";\n";
+            typeNames.push_back(name);
+        } else if (choice < 6) {
+            string name = "g" + n;
+            buffer += pick(typeNames) + " " + name;
+            if (random.below(2)) {
+                buffer += " = " + number();
+            }
+            buffer += ";\n";
+            globals.push_back(name);
+        } else if (choice < 8) {
+            string name = "a" + n;
+            int length = 1 + random.below(8);
+            buffer += pick(typeNames) + " " + name + "[" + to_string(length) + "] = {";
+            for (int i = 0; i < length; i++) {
+                buffer += (i ? ", " : "") + number();
+            }
+            buffer += "};\n";
+            arrays.emplace_back(name, length);
+        } else if (choice == 8) {
+            buffer += pick(typeNames) + " f" + n + "(int x);\n";
+            functions.emplace_back("f" + n, 1);
+        } else {
+            function();
+        }
+        items++;
+        flush();
+    }
+
+public:
+    Generator(const Options &options, FILE *file)
+            : options(options), random(options.seed), file(file), written(0), items(0), definitions(0) {}
+
+    /**
+     * Generate the whole corpus
+     */
+    void run() {
+        if (options.functions >= 0) {
+            while (definitions < options.functions) {
+                item();
+            }
+        } else {
+            while (written + buffer.size() < options.size) {
+                item();
+            }
+        }
+        flush(true);
+    }
+};
+
+/**
+ * Parse size with optional K, M or G suffix
+ * @param text - size text
+ * @return - number of bytes
+ */
+unsigned long long parseSize(const string &text) {
+    size_t end;
+    unsigned long long size = stoull(text, &end);
+    string suffix = text.substr(end);
+    if (suffix == "K" || suffix == "k") {
+        size <<= 10;
+    } else if (suffix == "M" || suffix == "m") {
+        size <<= 20;
+    } else if (suffix == "G" || suffix == "g") {
+        size <<= 30;
+    } else if (!suffix.empty()) {
+        throw invalid_argument("size suffix " + suffix);
+    }
+    return size;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (i + 1 >= argc) {
+                throw invalid_argument(arg);
+            }
+            string value = argv[++i];
+            if (arg == "--seed") {
+                options.seed = stoull(value);
+            } else if (arg == "--size") {
+                options.size = parseSize(value);
+            } else if (arg == "--functions") {
+                options.functions = stol(value);
+            } else if (arg == "--depth") {
+                options.depth = stoi(value);
+            } else if (arg == "--expression") {
+                options.expression = max(1, stoi(value));
+            } else if (arg == "--comments") {
+                options.comments = stod(value);
+            } else if (arg == "--output") {
+                options.output = value;
+            } else {
+                throw invalid_argument(arg);
+            }
+        }
+    } catch (exception &e) {
+        cerr << "usage: generator [--seed n] [--size bytes[K|M|G]] [--functions n] [--depth n] [--expression n]"
+                " [--comments density] [--output file]\n";
+        return 1;
+    }
+    FILE *file = options.output.empty() ? stdout : fopen(options.output.c_str(), "wb");
+    if (!file) {
+        cerr << "Cannot write " << options.output << "\n";
+        return 1;
+    }
+    Generator(options, file).run();
+    if (file != stdout) {
+        fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <iostream>
+#include "repository.hpp"
+
+/**
+ * Name of reference kind
+ * @param kind - kind of reference
+ * @return - name
+ */
+static const char *kindName(ReferenceKind kind) {
+    static const char *names[] = {"definition", "declaration", "use", "call"};
+    return names[static_cast<size_t>(kind)];
+}
+
+int main(int argc, char *argv[]) {
+    string indexPath = "index.cbor";
+    unsigned threads = 0;
+    ParseOptions options;
+    options.comments = false;
+    vector<string> roots;
+    vector<string> queries;
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--expand-macros") {
+                options.expandMacros = true;
+            } else if (arg == "--follow-includes") {
+                options.followIncludes = true;
+            } else if (arg.rfind("-I", 0) == 0 && arg.size() > 2) {
+                options.includePaths.push_back(arg.substr(2));
+            } else if (arg == "--index" || arg == "--threads" || arg == "--query" || arg == "-I") {
+                if (i + 1 >= argc) {
+                    throw invalid_argument(arg);
+                }
+                string value = argv[++i];
+                if (arg == "--index") {
+                    indexPath = value;
+                } else if (arg == "--threads") {
+                    threads = static_cast<unsigned>(stoul(value));
+                } else if (arg == "--query") {
+                    queries.push_back(value);
+                } else {
+                    options.includePaths.push_back(value);
+                }
+            } else if (arg.rfind("--", 0) == 0) {
+                throw invalid_argument(arg);
+            } else {
+                roots.push_back(arg);
+            }
+        }
+        if (roots.empty() && queries.empty()) {
+            throw invalid_argument("no input");
+        }
+    } catch (exception &e) {
+        cerr << "usage: indexer [--index file] [--threads n] [--expand-macros] [--follow-includes] [-I dir]..."
+                " [--query name]... [path]...\n";
+        return 1;
+    }
+    try {
+        RepositoryIndex index(options, threads);
+        index.load(indexPath);
+        if (!roots.empty()) {
+            auto start = chrono::steady_clock::now();
+            index.build(roots);
+            index.save(indexPath);
+            auto elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            size_t failed = 0;
+            for (const IndexedFile &file: index.indexedFiles()) {
+                if (!file.error.empty()) {
+                    cerr << file.path << ": " << file.error << "\n";
+                    failed++;
+                }
+            }
+            cout << index.indexedFiles().size() << " files (" << index.parsed() << " parsed, " << index.reused()
+                 << " unchanged, " << failed << " failed), " << index.size() << " names in " << elapsed << "ms\n";
+        }
+        for (const string &name: queries) {
+            for (const Location &location: index.find(name)) {
+                cout << index.indexedFiles()[location.file].path << ":" << location.line << ": "
+                     << kindName(location.kind) << " " << name << "\n";
+            }
+        }
+    } catch (exception &e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}